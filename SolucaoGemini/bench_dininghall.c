@@ -0,0 +1,443 @@
+/*
+ * bench_dininghall.c
+ * Benchmark da libdininghall: mede vazão e latência de dh_enter/dh_leave.
+ * Os tempos de "comida" e "refeição" são curtos (microssegundos) para que
+ * o custo de sincronização do monitor apareça nos números.
+ *
+ * Com -e all (ou uma lista "a,b,c") roda os motores lado a lado, todos
+ * sobre a MESMA carga: cada estudante usa a semente seed + id, então a
+ * sequência de sleeps é idêntica em todos os motores. -n também aceita uma
+ * lista ("32,64,128") para ver como cada motor escala com a contenção.
+ *
+ * As threads são criadas atrás de um portão (futex) e largam juntas: o
+ * tempo medido começa na largada, e a criação aparece numa coluna à parte.
+ *
+ * -a escolhe onde fixar as threads (dh_place.h); com uma lista ou "all"
+ * cada motor roda uma vez por política, para comparar a latência do
+ * monitor quando a barreira acorda alguém no mesmo núcleo ou em outro
+ * pacote.
+ *
+ * -c limita cada refeitório a N lugares (dh_set_capacity), para
+ * planejamento de capacidade: "ocup" é a média de lugares ocupados (do
+ * retorno de dh_enter ao retorno de dh_leave), "util%" é ocup / lugares,
+ * e a fila é o tempo em dh_enter (média e p99).
+ *
+ * -P divide os estudantes em classes de prioridade com os pesos dados
+ * ("3,1": classe 0 com peso 3, classe 1 com peso 1; dh_set_classes) e,
+ * depois de cada linha, mostra a espera em dh_enter de cada classe
+ * (p50/p90/p99). Só faz diferença junto com -c.
+ *
+ * Uso: ./bench_dininghall [-e motor|all|a,b] [-n n|n1,n2] [-i iteracoes]
+ *                         [-s min:max (us)] [-H refeitorios] [-r seed]
+ *                         [-a politica|all|a,b] [-c lugares] [-P p0,p1,...]
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "dininghall.h"
+#include "dh_place.h"
+
+/* Parâmetros do benchmark */
+typedef struct {
+    int num_students;
+    int num_iterations;
+    int min_sleep_us;
+    int max_sleep_us;
+    int num_halls;
+    int seats;                 // Lugares por refeitório (0 = sem limite)
+    int num_classes;           // -P: classes de prioridade (0 = sem classes)
+    int weights[DH_MAX_CLASSES];
+    unsigned seed;
+    dh_place_policy_t placement;
+    const dh_topology_t* topo;
+} BenchConfig;
+
+/* Histograma da espera em dh_enter: balde b = [2^(b-1), 2^b) µs */
+#define ENTER_BUCKETS 24
+
+/* Resultado de cada thread (sem compartilhamento durante a medição) */
+typedef struct {
+    int id;
+    atomic_int* gate;          // Largada: 0 = fechado (palavra de futex)
+    int cpu;                   // -a: CPU onde fixar (-1 = livre)
+    bool unpinned;             // -a: dh_place_self falhou
+    int cls;                   // -P: classe de prioridade
+    dh_hall_t* hall;
+    const BenchConfig* cfg;
+    unsigned rng;
+    long meals;
+    uint64_t enter_ns;
+    uint64_t leave_ns;
+    uint64_t seat_ns;          // Tempo ocupando um lugar
+    uint64_t enter_hist[ENTER_BUCKETS];
+} BenchStudent;
+
+/* Resultado agregado de uma rodada */
+typedef struct {
+    long meals;
+    double elapsed;            // Da largada até o último join
+    double creation;           // Criação das threads, antes da largada
+    uint64_t enter_ns;
+    uint64_t leave_ns;
+    uint64_t seat_ns;
+    uint64_t enter_hist[ENTER_BUCKETS];
+    uint64_t class_hist[DH_MAX_CLASSES][ENTER_BUCKETS];
+    dh_class_stats_t classes[DH_MAX_CLASSES]; // Somados entre os refeitórios
+    bool classes_ok;           // O motor aceitou dh_set_classes
+    int unpinned;              // -a: threads que não foram fixadas
+} BenchResult;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int bucket_us(uint64_t ns) {
+    uint64_t us = ns / 1000;
+    int b = 0;
+    while (us > 0 && b < ENTER_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    return b;
+}
+
+static void bench_sleep(BenchStudent* s) {
+    const BenchConfig* cfg = s->cfg;
+    int span = cfg->max_sleep_us - cfg->min_sleep_us + 1;
+    int us = cfg->min_sleep_us + (int)(rand_r(&s->rng) % (unsigned)span);
+    if (us > 0) usleep(us);
+}
+
+static void* bench_student(void* arg) {
+    BenchStudent* s = arg;
+
+    s->unpinned = dh_place_self(s->cpu) != 0;
+    while (atomic_load_explicit(s->gate, memory_order_acquire) == 0) {
+        syscall(SYS_futex, s->gate, FUTEX_WAIT_PRIVATE, 0, NULL, NULL, 0);
+    }
+
+    for (int i = 0; i < s->cfg->num_iterations; i++) {
+        bench_sleep(s); // get_food
+
+        uint64_t t0 = now_ns();
+        if (!dh_enter_class(s->hall, s->id, s->cls)) break;
+        uint64_t t1 = now_ns();
+        s->enter_ns += t1 - t0;
+        s->enter_hist[bucket_us(t1 - t0)]++;
+
+        bench_sleep(s); // dine
+
+        t0 = now_ns();
+        dh_leave(s->hall, s->id);
+        uint64_t t2 = now_ns();
+        s->leave_ns += t2 - t0;
+        s->seat_ns += t2 - t1;
+        s->meals++;
+    }
+
+    dh_done(s->hall, s->id);
+    return NULL;
+}
+
+/* Roda a carga inteira com um motor. Retorna false se o motor não existir. */
+static bool run_bench(const BenchConfig* cfg, const char* engine, BenchResult* out) {
+    // Estudante i vai para o refeitório i % H (instâncias independentes)
+    dh_hall_t** halls = calloc(cfg->num_halls, sizeof(dh_hall_t*));
+    for (int h = 0; h < cfg->num_halls; h++) {
+        int members = cfg->num_students / cfg->num_halls
+                    + (h < cfg->num_students % cfg->num_halls ? 1 : 0);
+        halls[h] = dh_create_engine(engine, members);
+        if (halls[h] == NULL) {
+            for (int k = 0; k < h; k++) dh_destroy(halls[k]);
+            free(halls);
+            return false;
+        }
+        dh_set_capacity(halls[h], cfg->seats);
+    }
+    memset(out, 0, sizeof(*out));
+    out->classes_ok = true;
+    if (cfg->num_classes > 0) {
+        for (int h = 0; h < cfg->num_halls; h++) {
+            if (dh_set_classes(halls[h], cfg->weights, cfg->num_classes) != 0) out->classes_ok = false;
+        }
+    }
+
+    pthread_t* threads = malloc(sizeof(pthread_t) * cfg->num_students);
+    BenchStudent* students = calloc(cfg->num_students, sizeof(BenchStudent));
+
+    atomic_int gate = 0;
+    uint64_t created = now_ns();
+    for (int i = 0; i < cfg->num_students; i++) {
+        students[i].id = i + 1;
+        students[i].gate = &gate;
+        students[i].cpu = dh_place_cpu(cfg->topo, cfg->placement, i, cfg->num_halls);
+        // Classes alternam dentro de cada refeitório
+        students[i].cls = cfg->num_classes > 0 ? (i / cfg->num_halls) % cfg->num_classes : 0;
+        students[i].hall = halls[i % cfg->num_halls];
+        students[i].cfg = cfg;
+        students[i].rng = cfg->seed + (unsigned)i;
+        pthread_create(&threads[i], NULL, bench_student, &students[i]);
+    }
+
+    // Todas criadas: larga todo mundo de uma vez
+    uint64_t start = now_ns();
+    atomic_store_explicit(&gate, 1, memory_order_release);
+    syscall(SYS_futex, &gate, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+    for (int i = 0; i < cfg->num_students; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    out->elapsed = (now_ns() - start) / 1e9;
+    out->creation = (start - created) / 1e9;
+    for (int i = 0; i < cfg->num_students; i++) {
+        out->meals += students[i].meals;
+        out->enter_ns += students[i].enter_ns;
+        out->leave_ns += students[i].leave_ns;
+        out->seat_ns += students[i].seat_ns;
+        out->unpinned += students[i].unpinned;
+        for (int b = 0; b < ENTER_BUCKETS; b++) {
+            out->enter_hist[b] += students[i].enter_hist[b];
+            out->class_hist[students[i].cls][b] += students[i].enter_hist[b];
+        }
+    }
+    for (int h = 0; h < cfg->num_halls; h++) {
+        for (int c = 0; c < cfg->num_classes; c++) {
+            dh_class_stats_t st;
+            dh_class_stats(halls[h], c, &st);
+            dh_class_stats_t* sum = &out->classes[c];
+            sum->arrivals += st.arrivals;
+            sum->admitted += st.admitted;
+            sum->aborted += st.aborted;
+            sum->aged += st.aged;
+            for (int k = 0; k < DH_MAX_CLASSES; k++) sum->paired[k] += st.paired[k];
+        }
+    }
+
+    for (int h = 0; h < cfg->num_halls; h++) dh_destroy(halls[h]);
+    free(halls);
+    free(students);
+    free(threads);
+    return true;
+}
+
+/* Limite superior (µs) do balde que cobre `pct`% das entradas */
+static uint64_t enter_pct_us(const uint64_t* hist, int pct) {
+    uint64_t total = 0, seen = 0;
+    for (int b = 0; b < ENTER_BUCKETS; b++) total += hist[b];
+    for (int b = 0; b < ENTER_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen * 100 >= total * (uint64_t)pct) return b == 0 ? 1 : 1ull << b;
+    }
+    return 1ull << (ENTER_BUCKETS - 1);
+}
+
+static void print_result(const BenchConfig* cfg, const char* engine, const BenchResult* r) {
+    double meals = r->meals > 0 ? (double)r->meals : 1.0;
+    double occupied = r->seat_ns / 1e9 / r->elapsed; // Lugares em uso, em média (todos os refeitórios)
+
+    printf("%-10s %-8s %6d %10ld %11.3f %9.3f %14.0f %11.2f %11.2f %9llu %7.2f ",
+           engine, dh_place_name(cfg->placement), cfg->num_students, r->meals,
+           r->creation * 1e3, r->elapsed, r->meals / r->elapsed, r->enter_ns / 1e3 / meals,
+           r->leave_ns / 1e3 / meals, (unsigned long long)enter_pct_us(r->enter_hist, 99), occupied);
+    if (cfg->seats > 0) printf("%6.1f\n", 100.0 * occupied / (cfg->seats * cfg->num_halls));
+    else printf("%6s\n", "-");
+    if (r->unpinned > 0) {
+        fflush(stdout); // Aviso logo abaixo da linha a que se refere
+        fprintf(stderr, "Aviso: %s/%s: %d de %d threads não foram fixadas.\n", engine,
+                dh_place_name(cfg->placement), r->unpinned, cfg->num_students);
+    }
+
+    if (cfg->num_classes == 0) return;
+    if (!r->classes_ok) {
+        printf("  (motor sem classes de prioridade: dh_enter_class virou dh_enter)\n");
+        return;
+    }
+    // "pares" = grupos abertos pela classe, pela classe do 2º a sentar
+    for (int c = 0; c < cfg->num_classes; c++) {
+        const dh_class_stats_t* st = &r->classes[c];
+        printf("  classe %d peso %-4d chegadas %-8lu p50 %-6llu p90 %-6llu p99 %-6llu us"
+               "  furaram %-6lu pares",
+               c, cfg->weights[c], st->arrivals,
+               (unsigned long long)enter_pct_us(r->class_hist[c], 50),
+               (unsigned long long)enter_pct_us(r->class_hist[c], 90),
+               (unsigned long long)enter_pct_us(r->class_hist[c], 99), st->aged);
+        for (int k = 0; k < cfg->num_classes; k++) printf(" %lu", st->paired[k]);
+        printf("\n");
+    }
+}
+
+/* "3,1" -> pesos das classes. Retorna quantas, ou -1 se inválido. */
+static int parse_weights(const char* str, int* weights) {
+    int n = 0;
+    const char* p = str;
+    while (*p) {
+        char* end;
+        long w = strtol(p, &end, 10);
+        if (end == p || w < 1 || w > 1000 || n == DH_MAX_CLASSES) return -1;
+        weights[n++] = (int)w;
+        if (*end == ',') end++;
+        else if (*end != '\0') return -1;
+        p = end;
+    }
+    return n > 0 ? n : -1;
+}
+
+static bool parse_range(const char* str, int* lo, int* hi) {
+    if (sscanf(str, "%d:%d", lo, hi) != 2) return false;
+    return *lo >= 0 && *hi >= *lo;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "Uso: %s [-e motor|all|a,b] [-n n|n1,n2] [-i iteracoes] "
+                    "[-s min:max (us)] [-H refeitorios] [-r seed] "
+                    "[-a politica|all|a,b] [-c lugares] [-P p0,p1,...]\n", prog);
+    fprintf(stderr, "Motores:");
+    for (int i = 0; dh_engine_at(i, NULL) != NULL; i++) {
+        fprintf(stderr, " %s", dh_engine_at(i, NULL));
+    }
+    fprintf(stderr, "\nPolíticas:");
+    for (int p = 0; p < DH_PLACE_NUM_POLICIES; p++) fprintf(stderr, " %s", dh_place_name(p));
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg = {
+        .num_students = 16,
+        .num_iterations = 1000,
+        .min_sleep_us = 0,
+        .max_sleep_us = 0,
+        .num_halls = 1,
+        .seed = 42,
+    };
+    const char* engines = "mutex";
+    const char* counts = "16";
+    const char* placements = "none";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "e:n:i:s:H:r:a:c:P:")) != -1) {
+        switch (opt) {
+        case 'e': engines = optarg; break;
+        case 'n': counts = optarg; break;
+        case 'i': cfg.num_iterations = atoi(optarg); break;
+        case 's':
+            if (!parse_range(optarg, &cfg.min_sleep_us, &cfg.max_sleep_us)) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'H': cfg.num_halls = atoi(optarg); break;
+        case 'r': cfg.seed = (unsigned)strtoul(optarg, NULL, 10); break;
+        case 'a': placements = optarg; break;
+        case 'c':
+            cfg.seats = atoi(optarg);
+            if (cfg.seats < 0 || cfg.seats == 1) {
+                fprintf(stderr, "Erro: pelo menos 2 lugares (ou 0 = sem limite).\n");
+                return 1;
+            }
+            break;
+        case 'P':
+            cfg.num_classes = parse_weights(optarg, cfg.weights);
+            if (cfg.num_classes < 0) {
+                fprintf(stderr, "Erro: pesos de 1 a 1000, até %d classes (ex.: 3,1).\n",
+                        DH_MAX_CLASSES);
+                return 1;
+            }
+            break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    printf("refeitorios=%d lugares=%d iteracoes=%d sleep=%d:%dus seed=%u\n",
+           cfg.num_halls, cfg.seats, cfg.num_iterations,
+           cfg.min_sleep_us, cfg.max_sleep_us, cfg.seed);
+    // Topologia lida uma vez; sem ela todas as políticas viram "none"
+    dh_topology_t topo = { 0 };
+    if (dh_topology_load(&topo) != 0) {
+        fprintf(stderr, "Aviso: topologia indisponível; threads não serão fixadas.\n");
+    } else {
+        printf("cpus=%d nucleos=%d pacotes=%d\n", topo.num_cpus, topo.num_cores,
+               topo.num_packages);
+    }
+    cfg.topo = &topo;
+
+    printf("%-10s %-8s %6s %10s %11s %9s %14s %11s %11s %9s %7s %6s\n", "motor", "posicao", "n",
+           "refeicoes", "criacao(ms)", "tempo(s)", "refeicoes/s", "enter(us)", "leave(us)",
+           "p99(us)", "ocup", "util%");
+
+    // "all" = todos os motores registrados; senão, lista separada por vírgulas
+    if (strcmp(engines, "all") == 0) {
+        static char all[256];
+        for (int i = 0; dh_engine_at(i, NULL) != NULL; i++) {
+            if (i > 0) strncat(all, ",", sizeof(all) - strlen(all) - 1);
+            strncat(all, dh_engine_at(i, NULL), sizeof(all) - strlen(all) - 1);
+        }
+        engines = all;
+    }
+    if (strcmp(placements, "all") == 0) {
+        static char all[128];
+        for (int p = 0; p < DH_PLACE_NUM_POLICIES; p++) {
+            if (p > 0) strncat(all, ",", sizeof(all) - strlen(all) - 1);
+            strncat(all, dh_place_name(p), sizeof(all) - strlen(all) - 1);
+        }
+        placements = all;
+    }
+
+    int status = 0;
+    char* count_list = strdup(counts);
+    char* save_count = NULL;
+    for (char* count = strtok_r(count_list, ",", &save_count); count;
+         count = strtok_r(NULL, ",", &save_count)) {
+        cfg.num_students = atoi(count);
+        if (cfg.num_halls < 1 || cfg.num_students < 2 * cfg.num_halls) {
+            fprintf(stderr, "Erro: cada refeitório precisa de pelo menos 2 estudantes.\n");
+            status = 1;
+            break;
+        }
+
+        char* engine_list = strdup(engines);
+        char* save_engine = NULL;
+        for (char* name = strtok_r(engine_list, ",", &save_engine); name;
+             name = strtok_r(NULL, ",", &save_engine)) {
+            char* place_list = strdup(placements);
+            char* save_place = NULL;
+            for (char* place = strtok_r(place_list, ",", &save_place); place;
+                 place = strtok_r(NULL, ",", &save_place)) {
+                int policy = dh_place_parse(place);
+                if (policy < 0) {
+                    fprintf(stderr, "Erro: política desconhecida '%s'.\n", place);
+                    status = 1;
+                    continue;
+                }
+                cfg.placement = policy;
+
+                BenchResult result;
+                if (!run_bench(&cfg, name, &result)) {
+                    fprintf(stderr, "Erro: motor desconhecido '%s'.\n", name);
+                    status = 1;
+                    break;
+                }
+                print_result(&cfg, name, &result);
+            }
+            free(place_list);
+        }
+        free(engine_list);
+    }
+
+    free(count_list);
+    dh_topology_free(&topo);
+    return status;
+}
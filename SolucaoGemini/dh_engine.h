@@ -0,0 +1,405 @@
+/*
+ * dh_engine.h
+ * Interface interna dos motores de sincronização da libdininghall.
+ *
+ * Cada motor implementa o mesmo protocolo (regras abaixo) com primitivas
+ * diferentes. O dh_hall_t é a "classe base": todo motor aloca uma struct
+ * própria cujo PRIMEIRO campo é um struct dh_hall, e a API pública só
+ * despacha pela vtable em hall->ops.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#ifndef DH_ENGINE_H
+#define DH_ENGINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "dininghall.h"
+#include "dh_waitstats.h"
+#include "dh_fuzz.h"
+#include "dh_sync.h"
+#include "dh_probes.h"
+
+/*
+ * Contadores do protocolo (protegidos pelo mecanismo de cada motor).
+ * eating_count é atômico por causa da saída rápida (dh_fast_leave), que
+ * o decrementa sem o lock; com o lock, ++/-- continuam valendo.
+ */
+typedef struct {
+    atomic_int eating_count;
+    int waiting_to_eat;
+    int waiting_to_leave;
+
+    int capacity;              // Lugares (0 = sem limite); fixo depois de dh_set_capacity
+
+    /* Controle de fim de jogo */
+    int total_students;        // Total de threads iniciadas
+    int finished_students;     // Quantas threads já encerraram o loop principal
+} dh_state_t;
+
+/* Vtable de um motor. As operações assíncronas são opcionais (NULL). */
+typedef struct dh_engine_ops {
+    const char* name;
+    const char* description;
+
+    dh_hall_t* (*create)(int total_students);
+    void (*destroy)(dh_hall_t* hall);
+
+    bool (*enter)(dh_hall_t* hall, int id);
+    void (*leave)(dh_hall_t* hall, int id);
+    void (*done)(dh_hall_t* hall, int id);
+
+    dh_status_t (*try_enter)(dh_hall_t* hall, int id);
+    dh_status_t (*try_leave)(dh_hall_t* hall, int id);
+    dh_status_t (*enter_async)(dh_hall_t* hall, dh_waiter_t* waiter);
+    dh_status_t (*leave_async)(dh_hall_t* hall, dh_waiter_t* waiter);
+
+    bool (*enter_class)(dh_hall_t* hall, int id, int cls); // Opcional: classes de prioridade
+} dh_engine_ops;
+
+/*
+ * Classes de prioridade (dh_set_classes). Protegidas pelo lock do motor
+ * que as implementa; sem classes configuradas todos contam na classe 0.
+ */
+typedef struct {
+    int num_classes;                      // 0 = desligadas
+    int waiting[DH_MAX_CLASSES];          // Esperando para sentar, por classe
+    uint64_t vtime[DH_MAX_CLASSES];       // Tempo virtual: cresce DH_CLASS_VSCALE / peso por admissão
+    uint64_t vnow;                        // Tempo virtual da última admissão
+    int passed[DH_MAX_CLASSES];           // Admissões de outras classes desde a última desta
+    int opener;                           // Classe de quem abriu o grupo atual (0 -> 1 comendo)
+    dh_class_stats_t stats[DH_MAX_CLASSES];
+} dh_classes_t;
+
+#define DH_CLASS_VSCALE (1u << 20)
+
+/*
+ * Cópia publicada dos contadores para observadores (seqlock).
+ * `seq` ímpar = escrita em andamento. Os campos são atômicos relaxados
+ * só para a leitura concorrente não ser corrida de dados em C11.
+ */
+typedef struct {
+    atomic_uint seq;
+    atomic_int eating_count;
+    atomic_int waiting_to_eat;
+    atomic_int waiting_to_leave;
+    atomic_int finished_students;
+} dh_published_t;
+
+/* Base comum a todos os motores */
+struct dh_hall {
+    const dh_engine_ops* ops;
+    dh_state_t state;
+    dh_published_t published;  // Atualizado por dh_publish() dentro da seção crítica
+
+    int check_mode;            // dh_check_mode_t
+    atomic_ulong violations;
+
+    dh_classes_t classes;
+};
+
+/* Motores disponíveis (arquivos dh_engine_*.c) */
+extern const dh_engine_ops dh_engine_mutex;
+extern const dh_engine_ops dh_engine_sem;
+extern const dh_engine_ops dh_engine_futex;
+extern const dh_engine_ops dh_engine_mcs;
+extern const dh_engine_ops dh_engine_clh;
+extern const dh_engine_ops dh_engine_cohort;
+extern const dh_engine_ops dh_engine_spin;
+extern const dh_engine_ops dh_engine_fc;
+extern const dh_engine_ops dh_engine_rcl;
+
+/* Inicializa a base; chamado pelo create de cada motor */
+static inline void dh_hall_init(dh_hall_t* hall, const dh_engine_ops* ops, int total_students) {
+    hall->ops = ops;
+    hall->state.eating_count = 0;
+    hall->state.waiting_to_eat = 0;
+    hall->state.waiting_to_leave = 0;
+    hall->state.capacity = 0;
+    hall->state.total_students = total_students;
+    hall->state.finished_students = 0;
+
+    atomic_init(&hall->published.seq, 0);
+    atomic_init(&hall->published.eating_count, 0);
+    atomic_init(&hall->published.waiting_to_eat, 0);
+    atomic_init(&hall->published.waiting_to_leave, 0);
+    atomic_init(&hall->published.finished_students, 0);
+
+    hall->check_mode = DH_CHECK_LOG;
+    atomic_init(&hall->violations, 0);
+
+    memset(&hall->classes, 0, sizeof(hall->classes));
+    hall->classes.stats[0].weight = 1;
+}
+
+/* Caminho frio de dh_check (dininghall.c) */
+void dh_check_failed(dh_hall_t* hall);
+
+/*
+ * Invariantes do protocolo (ver dh_set_check_mode), no estado que está
+ * para ser publicado. Tudo vira uma expressão só, sem desvios no meio, e
+ * um desvio marcado como improvável; compile com -DDH_NO_CHECKS para tirar.
+ */
+static inline void dh_check(dh_hall_t* hall) {
+#ifndef DH_NO_CHECKS
+    const dh_state_t* s = &hall->state;
+    int e = atomic_load_explicit(&s->eating_count, memory_order_relaxed);
+    int w = s->waiting_to_eat;
+    int l = s->waiting_to_leave;
+    int f = s->finished_students;
+
+    bool bad = ((e | w | l | f) < 0)            // Contador negativo
+             | ((e == 1) & ((w | l) == 0))      // Comendo sozinho, sem par a caminho
+             | (l > e)                          // Na barreira sem estar comendo
+             | (f > s->total_students)
+             | ((s->capacity > 0) & (e > s->capacity)); // Mais gente que lugar
+    if (__builtin_expect(bad, 0)) dh_check_failed(hall);
+#else
+    (void)hall;
+#endif
+}
+
+/*
+ * Abre uma escrita no seqlock (seq fica ímpar); retorna o seq par anterior.
+ * Se outro escritor estiver no meio (preemptado, com poucas CPUs), cede a
+ * CPU em vez de girar uma fatia de tempo inteira.
+ */
+static inline unsigned dh_publish_begin(dh_published_t* p) {
+    unsigned seq = atomic_load_explicit(&p->seq, memory_order_relaxed);
+    int spins = 0;
+    do {
+        while (seq & 1) {
+            dh_spin_backoff(&spins);
+            seq = atomic_load_explicit(&p->seq, memory_order_relaxed);
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&p->seq, &seq, seq + 1,
+                                                    memory_order_acquire,
+                                                    memory_order_relaxed));
+    atomic_thread_fence(memory_order_release);
+    return seq;
+}
+
+static inline void dh_publish_end(dh_published_t* p, unsigned seq) {
+    atomic_store_explicit(&p->seq, seq + 2, memory_order_release);
+}
+
+/*
+ * Lado escritor do seqlock: copia `state` para `published`. Os motores
+ * chamam isto dentro da seção crítica, depois de mudar os contadores e
+ * antes de soltar o lock (ou de dormir esperando). O CAS para seq ímpar
+ * tolera dois escritores ao mesmo tempo; com o lock do motor ele nunca
+ * disputa. Escritores nunca esperam leitores.
+ */
+static inline void dh_publish(dh_hall_t* hall) {
+    dh_published_t* p = &hall->published;
+    const dh_state_t* s = &hall->state;
+
+    dh_check(hall); // Toda transição passa por aqui
+
+    unsigned seq = dh_publish_begin(p);
+    atomic_store_explicit(&p->eating_count, s->eating_count, memory_order_relaxed);
+    atomic_store_explicit(&p->waiting_to_eat, s->waiting_to_eat, memory_order_relaxed);
+    atomic_store_explicit(&p->waiting_to_leave, s->waiting_to_leave, memory_order_relaxed);
+    atomic_store_explicit(&p->finished_students, s->finished_students, memory_order_relaxed);
+    dh_publish_end(p, seq);
+}
+
+/*
+ * Medição de uma espera (dh_waitstats.h). Uso:
+ *     dh_wait_mark m;
+ *     bool timed = dh_wait_begin(&m);
+ *     ...bloqueia...
+ *     if (timed) dh_wait_end(&m, DH_WAIT_PAIR);
+ * Desligado, custa só a leitura relaxada da flag.
+ */
+typedef struct {
+    uint64_t wall_ns;
+    uint64_t cpu_ns;
+} dh_wait_mark;
+
+extern atomic_bool dh_waitstats_on;
+void dh_wait_start(dh_wait_mark* m);
+void dh_wait_account(const dh_wait_mark* m, dh_wait_reason_t reason);
+
+static inline bool dh_wait_begin(dh_wait_mark* m) {
+    if (!atomic_load_explicit(&dh_waitstats_on, memory_order_relaxed)) return false;
+    dh_wait_start(m);
+    return true;
+}
+
+static inline void dh_wait_end(const dh_wait_mark* m, dh_wait_reason_t reason) {
+    dh_wait_account(m, reason);
+}
+
+/*
+ * Ganchos de gravação/reprodução do escalonamento (dh_sched.h), usados
+ * pelo motor mutex em volta de cada aquisição do lock e de cada espera:
+ *     bool turn = dh_sched_turn(id, DH_SCHED_LOCK);  // Reproduzindo: espera a vez
+ *     pthread_mutex_lock(...);
+ *     dh_sched_taken(id, DH_SCHED_LOCK, turn);       // Grava; passa a vez
+ * A saída rápida (FAST) é um turno próprio: reproduzindo, o arquivo diz
+ * se a saída foi pelo CAS ou pelo lock (dh_sched_next_is). A volta do
+ * primeiro do par da barreira (dh_pair_wait) é um turno PAIR.
+ * Desligados, dh_sched_active() é só uma leitura relaxada.
+ */
+enum { DH_SCHED_LOCK = 1, DH_SCHED_WAKE, DH_SCHED_RAND, DH_SCHED_FAST, DH_SCHED_PAIR };
+enum { DH_SCHED_RECORDING = 1, DH_SCHED_REPLAYING = 2 };
+
+extern atomic_int dh_sched_mode;
+bool dh_sched_turn(int id, int kind);
+void dh_sched_taken(int id, int kind, bool turn);
+void dh_sched_pass(bool turn);    // Passa a vez sem gravar (o turno não aconteceu)
+bool dh_sched_next_is(int id, int kind);
+bool dh_sched_replaying(void);    // Reproduzindo e o arquivo ainda não acabou
+
+static inline bool dh_sched_active(void) {
+    return atomic_load_explicit(&dh_sched_mode, memory_order_relaxed) != 0;
+}
+
+/*
+ * Pontos de perturbação do fuzzer (dh_fuzz.h). `s` é o estado com o lock
+ * na mão, ou NULL no ponto LOCK. Desligado, só a leitura da flag.
+ */
+enum { DH_FUZZ_LOCK, DH_FUZZ_WAIT, DH_FUZZ_WAKE, DH_FUZZ_SIGNAL, DH_FUZZ_NUM_POINTS };
+
+extern atomic_bool dh_fuzz_on;
+void dh_fuzz_point(int point, const dh_state_t* s);
+
+static inline void dh_fuzz(int point, const dh_state_t* s) {
+    if (atomic_load_explicit(&dh_fuzz_on, memory_order_relaxed)) dh_fuzz_point(point, s);
+}
+
+/* --- Regras do protocolo (chamar com o estado protegido) --- */
+
+/* Sobrou lugar? (capacity == 0: sem limite) */
+static inline bool dh_seat_free(const dh_state_t* s) {
+    return s->capacity == 0 || s->eating_count < s->capacity;
+}
+
+/* Posso sentar? (Alguém comendo OU tenho par na fila) E há lugar */
+static inline bool dh_can_sit(const dh_state_t* s) {
+    return ((s->eating_count > 0) || (s->waiting_to_eat >= 2)) && dh_seat_free(s);
+}
+
+/*
+ * Depois de uma admissão, quantos da fila acordar: sem limite, todos podem
+ * sentar (acorda todos); com limite, só um, e só se ainda houver lugar.
+ * Quem sentar acorda o próximo, em cadeia, até lotar.
+ */
+static inline bool dh_wake_all_sitters(const dh_state_t* s) {
+    return s->capacity == 0;
+}
+
+/*
+ * Devo desistir? (Deadlock prevention)
+ * Se (Total - Finalizados) < 2 e ninguém está comendo, nunca formarei par.
+ */
+static inline bool dh_must_abort(const dh_state_t* s) {
+    int active_students = s->total_students - s->finished_students;
+    return s->eating_count == 0 && active_students < 2;
+}
+
+/* Quem está na barreira de saída (eating == 2) já pode ir? */
+static inline bool dh_leave_released(const dh_state_t* s) {
+    return s->waiting_to_leave >= 2 || s->eating_count != 2;
+}
+
+/*
+ * Saída em par. O primeiro a chegar na barreira (eating == 2) registra no
+ * monitor uma palavra de futex da própria pilha, solta o lock e dorme
+ * nela. Quem libera a barreira - o par saindo ou alguém sentando (2 -> 3)
+ * - tira o primeiro do refeitório na MESMA seção crítica e o acorda
+ * direto: um despertar, sem broadcast, e o primeiro volta sem retomar o
+ * lock. Sem isso a saída do par custava duas seções críticas e o
+ * primeiro ainda disputava o lock ao acordar.
+ */
+typedef struct {
+    atomic_int released;
+    int id;
+} dh_pair_exit_t;
+
+/* Primeiro do par: registra a espera (com o lock; depois soltar e chamar dh_pair_wait) */
+static inline void dh_pair_register(dh_state_t* s, dh_pair_exit_t** slot, dh_pair_exit_t* me, int id) {
+    atomic_init(&me->released, 0);
+    me->id = id;
+    s->waiting_to_leave++;
+    *slot = me;
+}
+
+/*
+ * Com o lock, depois de mudar eating_count: se a barreira liberou, conclui
+ * a saída do primeiro por ele e o acorda. Retorna true se alguém saiu.
+ */
+static inline bool dh_pair_release(dh_state_t* s, dh_pair_exit_t** slot) {
+    dh_pair_exit_t* first = *slot;
+    if (first == NULL || !dh_leave_released(s)) return false;
+    *slot = NULL;
+    s->waiting_to_leave--;
+    s->eating_count--;
+    DH_PROBE(leave_left, first->id, s);
+    // Depois do store o primeiro pode voltar e a pilha dele sumir: o wake
+    // num endereço morto é inofensivo (toda espera em futex reconfere)
+    atomic_store_explicit(&first->released, 1, memory_order_release);
+    dh_futex_wake(&first->released, 1);
+    return true;
+}
+
+/* Sem o lock: espera dh_pair_release */
+static inline void dh_pair_wait(dh_pair_exit_t* me) {
+    dh_wait_mark m;
+    bool timed = dh_wait_begin(&m);
+    while (atomic_load_explicit(&me->released, memory_order_acquire) == 0) {
+        dh_futex_wait(&me->released, 0, NULL);
+    }
+    if (timed) dh_wait_end(&m, DH_WAIT_BARRIER);
+}
+
+/*
+ * Saída rápida, SEM o lock do motor: só decrementa se sobrarem 3 ou mais
+ * comendo. Nesse caso ninguém fica sozinho e não pode haver ninguém
+ * esperando por causa desta saída: a barreira só existe com eating == 2,
+ * e quem espera para sentar só espera com eating == 0 ou com o refeitório
+ * lotado (eating == capacity; aí a saída vai pelo lock para liberar o lugar). Quem segura o lock
+ * e leu eating >= 3 também decide certo, pois a saída rápida nunca passa
+ * de 4 para menos de 3. Retorna false se o chamador deve ir pelo caminho
+ * normal (fronteiras 2 e 0, onde há quem acordar). O ponto leave_left
+ * daqui só traz eating_count; os outros contadores (sem lock) vão como -1.
+ * Gravando, cada CAS que deu certo vira um turno FAST; reproduzindo, só
+ * tenta quando o próximo turno do estudante no arquivo for FAST.
+ */
+static inline bool dh_fast_leave(dh_hall_t* hall, int id) {
+    bool turn = false;
+    if (dh_sched_active()) {
+        if (!dh_sched_next_is(id, DH_SCHED_FAST)) return false; // Foi pelo lock
+        turn = dh_sched_turn(id, DH_SCHED_FAST);
+    }
+
+    atomic_int* eating = &hall->state.eating_count;
+    int n = atomic_load_explicit(eating, memory_order_relaxed);
+
+    int capacity = hall->state.capacity;
+    while (n >= 4 && (capacity == 0 || n < capacity)) {
+        if (atomic_compare_exchange_weak_explicit(eating, &n, n - 1,
+                                                  memory_order_release,
+                                                  memory_order_relaxed)) {
+            // Republica só eating_count, lendo o valor mais recente
+            dh_published_t* p = &hall->published;
+            unsigned seq = dh_publish_begin(p);
+            atomic_store_explicit(&p->eating_count,
+                                  atomic_load_explicit(eating, memory_order_relaxed),
+                                  memory_order_relaxed);
+            dh_publish_end(p, seq);
+            DH_PROBE5(leave_left, id, n - 1, -1, -1, -1);
+            if (dh_sched_active()) dh_sched_taken(id, DH_SCHED_FAST, turn);
+            return true;
+        }
+    }
+    // Reproduzindo e divergiu (o CAS gravado não cabe agora): segue pelo lock
+    if (turn) dh_sched_pass(turn);
+    return false;
+}
+
+#endif /* DH_ENGINE_H */
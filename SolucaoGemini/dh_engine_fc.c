@@ -0,0 +1,104 @@
+/*
+ * dh_engine_fc.c
+ * Motor "fc" (flat combining, Hendler et al.): em vez de todo estudante
+ * disputar o lock para mexer em meia dúzia de contadores, cada um publica
+ * o pedido (enter/leave/done) no seu slot e tenta virar o "combinador".
+ * Quem consegue aplica os pedidos de TODOS em lote (dh_slots_combine) com
+ * as mesmas regras do motor mutex. O estado do monitor fica no cache de
+ * um só núcleo por lote, e os demais só tocam na própria linha de cache.
+ *
+ * Ninguém fica girando esperando o par: um pedido que não pode ser
+ * atendido continua pendente no slot, e o dono dorme num futex até
+ * algum combinador futuro concluí-lo.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "dh_engine.h"
+#include "dh_slots.h"
+#include "dh_sync.h"
+
+typedef struct {
+    dh_hall_t base;
+
+    _Alignas(DH_CACHE_LINE) atomic_int combiner;   // 1 = alguém está combinando
+    _Alignas(DH_CACHE_LINE) atomic_uint published; // Conta publicações
+    dh_slot_list slots;
+} FcHall;
+
+/*
+ * Combina enquanto houver publicações novas. Depois de soltar o papel de
+ * combinador, re-lê `published`: se alguém publicou e não conseguiu
+ * virar combinador nesse intervalo, tentamos de novo (senão o pedido
+ * dele ficaria sem ninguém para aplicá-lo).
+ */
+static void fc_combine(FcHall* hall) {
+    while (true) {
+        int expected = 0;
+        if (!atomic_compare_exchange_strong(&hall->combiner, &expected, 1)) {
+            return; // O combinador atual verá nossa publicação
+        }
+
+        unsigned seen;
+        do {
+            seen = atomic_load(&hall->published);
+            dh_slots_combine(&hall->base.state, &hall->slots);
+            dh_publish(&hall->base);
+        } while (atomic_load(&hall->published) != seen);
+
+        atomic_store(&hall->combiner, 0);
+        if (atomic_load(&hall->published) == seen) return;
+    }
+}
+
+static int fc_request(dh_hall_t* base, dh_op_t op, int id) {
+    FcHall* hall = (FcHall*)base;
+    dh_slot* slot = dh_slot_for_thread(&hall->slots);
+    if (slot == NULL) dh_slot_alloc_failed(base);
+
+    dh_slot_publish(slot, op, id);
+    atomic_fetch_add(&hall->published, 1);
+    fc_combine(hall);
+    return dh_slot_wait(slot);
+}
+
+static dh_hall_t* fc_create(int total_students) {
+    FcHall* hall = aligned_alloc(DH_CACHE_LINE, sizeof(FcHall));
+    if (hall == NULL) return NULL;
+
+    dh_hall_init(&hall->base, &dh_engine_fc, total_students);
+    atomic_init(&hall->combiner, 0);
+    atomic_init(&hall->published, 0);
+    dh_slots_init(&hall->slots);
+    return &hall->base;
+}
+
+static void fc_destroy(dh_hall_t* base) {
+    FcHall* hall = (FcHall*)base;
+    dh_slots_free(&hall->slots);
+    free(hall);
+}
+
+static bool fc_enter(dh_hall_t* hall, int id) {
+    return fc_request(hall, DH_OP_ENTER, id) == 1;
+}
+
+static void fc_leave(dh_hall_t* hall, int id) {
+    fc_request(hall, DH_OP_LEAVE, id);
+}
+
+static void fc_done(dh_hall_t* hall, int id) {
+    fc_request(hall, DH_OP_DONE, id);
+}
+
+const dh_engine_ops dh_engine_fc = {
+    .name = "fc",
+    .description = "flat combining: pedidos por slot aplicados em lote por um combinador",
+    .create = fc_create,
+    .destroy = fc_destroy,
+    .enter = fc_enter,
+    .leave = fc_leave,
+    .done = fc_done,
+};
@@ -0,0 +1,213 @@
+/*
+ * dh_engine_lock.c
+ * Motores "futex", "mcs", "clh" e "cohort": mesma lógica do motor mutex,
+ * mas o lock do monitor é um dh_lock (dh_lock.h) escolhido pelo motor, e
+ * as variáveis de condição são de futex (dh_lock_cond), que funcionam
+ * com qualquer tipo de lock. Nada passa pela pthread.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "dh_engine.h"
+#include "dh_lock.h"
+
+typedef struct {
+    dh_hall_t base;
+
+    dh_lock lock;
+    dh_lock_cond ok_to_sit;
+    dh_pair_exit_t* pair_exit; // Primeiro do par na barreira (dh_pair_release)
+} LockHall;
+
+static dh_hall_t* lock_hall_create(const dh_engine_ops* ops, dh_lock_kind kind, int total_students) {
+    LockHall* hall = aligned_alloc(DH_LOCK_CACHE_LINE, sizeof(LockHall));
+    if (hall == NULL) return NULL;
+
+    dh_hall_init(&hall->base, ops, total_students);
+    hall->pair_exit = NULL;
+    atomic_init(&hall->ok_to_sit.seq, 0);
+    if (dh_lock_init(&hall->lock, kind) != 0) {
+        free(hall);
+        return NULL;
+    }
+    return &hall->base;
+}
+
+static dh_hall_t* futex_create(int total_students) {
+    return lock_hall_create(&dh_engine_futex, DH_LOCK_FUTEX, total_students);
+}
+
+static dh_hall_t* mcs_create(int total_students) {
+    return lock_hall_create(&dh_engine_mcs, DH_LOCK_MCS, total_students);
+}
+
+static dh_hall_t* clh_create(int total_students) {
+    return lock_hall_create(&dh_engine_clh, DH_LOCK_CLH, total_students);
+}
+
+static dh_hall_t* cohort_create(int total_students) {
+    return lock_hall_create(&dh_engine_cohort, DH_LOCK_COHORT, total_students);
+}
+
+static void lock_hall_destroy(dh_hall_t* base) {
+    LockHall* hall = (LockHall*)base;
+    dh_lock_destroy(&hall->lock);
+    free(hall);
+}
+
+/* Publica os contadores para dh_snapshot e solta o lock */
+static void lock_hall_unlock(LockHall* hall) {
+    dh_fuzz(DH_FUZZ_SIGNAL, &hall->base.state);
+    dh_publish(&hall->base);
+    dh_lock_release(&hall->lock);
+}
+
+/*
+ * Pega o lock. Os locks em fila não têm trylock: com a contabilidade de
+ * esperas ligada, toda aquisição conta como espera pelo lock.
+ */
+static void lock_hall_lock(LockHall* hall) {
+    dh_fuzz(DH_FUZZ_LOCK, NULL);
+    dh_wait_mark m;
+    bool timed = dh_wait_begin(&m);
+    dh_lock_acquire(&hall->lock);
+    if (timed) dh_wait_end(&m, DH_WAIT_LOCK);
+}
+
+/* Publica os contadores e espera na condvar (retomar o lock conta junto) */
+static void lock_hall_wait(LockHall* hall, dh_lock_cond* cond, dh_wait_reason_t reason) {
+    dh_fuzz(DH_FUZZ_WAIT, &hall->base.state);
+    dh_publish(&hall->base);
+    dh_wait_mark m;
+    bool timed = dh_wait_begin(&m);
+    dh_lock_cond_wait(cond, &hall->lock);
+    if (timed) dh_wait_end(&m, reason);
+    dh_fuzz(DH_FUZZ_WAKE, &hall->base.state);
+}
+
+static bool lock_hall_enter(dh_hall_t* base, int id) {
+    LockHall* hall = (LockHall*)base;
+    dh_state_t* s = &base->state;
+    lock_hall_lock(hall);
+
+    s->waiting_to_eat++;
+    DH_PROBE(enter_request, id, s);
+
+    while (!dh_can_sit(s)) {
+        if (dh_must_abort(s)) {
+            s->waiting_to_eat--;
+            DH_PROBE(enter_abort, id, s);
+            lock_hall_unlock(hall);
+            return false;
+        }
+        DH_PROBE(enter_wait, id, s);
+        lock_hall_wait(hall, &hall->ok_to_sit, DH_WAIT_PAIR);
+    }
+
+    s->waiting_to_eat--;
+    s->eating_count++;
+    DH_PROBE(enter_admitted, id, s);
+
+    // 2 -> 3: quem estava na barreira de saída já pode ir. Tem que ser
+    // aqui, porque com >= 4 comendo as saídas são rápidas e não acordam.
+    // Antes de decidir o acordar: a saída dele pode vagar um lugar.
+    dh_pair_release(s, &hall->pair_exit);
+
+    // Com alguém comendo, todos os que esperam podem sentar: acorda todos
+    // de uma vez. As saídas rápidas não sinalizam ok_to_sit, então acordar
+    // um por vez viraria uma fila de trocas de contexto. Com lugares
+    // limitados acorda só o próximo, se ainda houver lugar (em cadeia).
+    if (s->waiting_to_eat > 0) {
+        if (dh_wake_all_sitters(s)) dh_lock_cond_broadcast(&hall->ok_to_sit);
+        else if (dh_seat_free(s)) dh_lock_cond_signal(&hall->ok_to_sit);
+    }
+
+    lock_hall_unlock(hall);
+    return true;
+}
+
+static void lock_hall_leave(dh_hall_t* base, int id) {
+    LockHall* hall = (LockHall*)base;
+    dh_state_t* s = &base->state;
+
+    // Refeitório cheio (>= 4 comendo): sai sem lock e sem acordar ninguém
+    if (dh_fast_leave(base, id)) return;
+
+    lock_hall_lock(hall);
+    DH_PROBE(leave_request, id, s);
+
+    // Primeiro do par: quem liberar a barreira conclui a saída por mim
+    if (s->eating_count == 2 && s->waiting_to_leave == 0) {
+        dh_pair_exit_t me;
+        dh_pair_register(s, &hall->pair_exit, &me, id);
+        DH_PROBE(leave_wait, id, s);
+        dh_fuzz(DH_FUZZ_WAIT, s);
+        lock_hall_unlock(hall);
+        dh_pair_wait(&me);
+        return;
+    }
+
+    // Segundo do par (ou sem barreira): sai e, se for o caso, leva o
+    // primeiro junto - os dois lugares vagam nesta seção crítica
+    s->eating_count--;
+    DH_PROBE(leave_left, id, s);
+    dh_pair_release(s, &hall->pair_exit);
+
+    dh_lock_cond_signal(&hall->ok_to_sit);
+
+    lock_hall_unlock(hall);
+}
+
+static void lock_hall_done(dh_hall_t* base, int id) {
+    LockHall* hall = (LockHall*)base;
+    lock_hall_lock(hall);
+    base->state.finished_students++;
+    DH_PROBE(done, id, &base->state);
+
+    // Todos precisam checar a condição de aborto
+    dh_lock_cond_broadcast(&hall->ok_to_sit);
+
+    lock_hall_unlock(hall);
+}
+
+const dh_engine_ops dh_engine_futex = {
+    .name = "futex",
+    .description = "lock e condvars próprios com atômicos + futex",
+    .create = futex_create,
+    .destroy = lock_hall_destroy,
+    .enter = lock_hall_enter,
+    .leave = lock_hall_leave,
+    .done = lock_hall_done,
+};
+
+const dh_engine_ops dh_engine_mcs = {
+    .name = "mcs",
+    .description = "lock de fila MCS + condvars de futex",
+    .create = mcs_create,
+    .destroy = lock_hall_destroy,
+    .enter = lock_hall_enter,
+    .leave = lock_hall_leave,
+    .done = lock_hall_done,
+};
+
+const dh_engine_ops dh_engine_clh = {
+    .name = "clh",
+    .description = "lock de fila CLH + condvars de futex",
+    .create = clh_create,
+    .destroy = lock_hall_destroy,
+    .enter = lock_hall_enter,
+    .leave = lock_hall_leave,
+    .done = lock_hall_done,
+};
+
+const dh_engine_ops dh_engine_cohort = {
+    .name = "cohort",
+    .description = "lock de coorte NUMA (MCS por nó + global); $DH_COHORT_NODES simula nós",
+    .create = cohort_create,
+    .destroy = lock_hall_destroy,
+    .enter = lock_hall_enter,
+    .leave = lock_hall_leave,
+    .done = lock_hall_done,
+};
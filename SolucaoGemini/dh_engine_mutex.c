@@ -0,0 +1,545 @@
+/*
+ * dh_engine_mutex.c
+ * Motor "mutex": a lógica original do dining_hall.c v2.0 (pthread mutex +
+ * duas variáveis de condição). É o motor padrão e o único que suporta a
+ * API não bloqueante (dh_try_* / dh_*_async).
+ *
+ * Esperas assíncronas (dh_*_async) ficam em filas FIFO intrusivas dentro
+ * do monitor. Toda operação que muda o estado chama hall_dispatch(), que
+ * conclui (sob o lock) as esperas que ficaram liberadas; as notificações
+ * (callback/eventfd) são feitas depois de soltar o lock.
+ *
+ * Classes de prioridade (dh_set_classes): cada classe espera na sua
+ * condvar, e com lugares limitados só a classe com a vez (class_next)
+ * pode sentar; acordar "o próximo" é acordar alguém dessa classe. As
+ * esperas assíncronas e dh_enter contam como classe 0.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "dh_engine.h"
+
+/* Fila FIFO intrusiva de dh_waiter_t */
+typedef struct {
+    dh_waiter_t* head;
+    dh_waiter_t* tail;
+} WaiterQueue;
+
+/* Estrutura para o Monitor do Refeitório */
+typedef struct {
+    dh_hall_t base;            // waiting_to_eat inclui esperas síncronas e assíncronas
+
+    pthread_mutex_t lock;
+    pthread_cond_t ok_to_sit[DH_MAX_CLASSES]; // Uma por classe de prioridade
+
+    WaiterQueue async_enter;   // Esperando par para sentar
+    WaiterQueue async_leave;   // Esperando par na barreira de saída
+    dh_pair_exit_t* pair_exit; // Primeiro do par, síncrono, na barreira (dh_pair_release)
+} MutexHall;
+
+/* --- Filas de espera assíncrona --- */
+
+static void queue_push(WaiterQueue* q, dh_waiter_t* w) {
+    w->next = NULL;
+    if (q->tail) q->tail->next = w;
+    else q->head = w;
+    q->tail = w;
+}
+
+static dh_waiter_t* queue_pop(WaiterQueue* q) {
+    dh_waiter_t* w = q->head;
+    q->head = w->next;
+    if (q->head == NULL) q->tail = NULL;
+    return w;
+}
+
+/* --- Classes de prioridade --- */
+
+/*
+ * Classe que tem a vez de sentar (-1 se ninguém espera): a de menor
+ * tempo virtual, salvo se alguma foi preterida DH_CLASS_AGING vezes.
+ */
+static int class_next(const dh_classes_t* c) {
+    int best = -1;
+    for (int k = 0; k < c->num_classes; k++) {
+        if (c->waiting[k] == 0) continue;
+        if (c->passed[k] >= DH_CLASS_AGING) return k;
+        if (best < 0 || c->vtime[k] < c->vtime[best]) best = k;
+    }
+    return best;
+}
+
+static void class_arrive(dh_classes_t* c, int cls) {
+    c->stats[cls].arrivals++;
+    // Classe que volta a esperar não acumula crédito do tempo parada
+    if (c->waiting[cls]++ == 0) {
+        if (c->vtime[cls] < c->vnow) c->vtime[cls] = c->vnow;
+        c->passed[cls] = 0;
+    }
+}
+
+/* Desfaz a chegada: desistiu (`aborted`) ou foi só um try */
+static void class_withdraw(dh_classes_t* c, int cls, bool aborted) {
+    c->waiting[cls]--;
+    if (aborted) c->stats[cls].aborted++;
+    else c->stats[cls].arrivals--;
+}
+
+/* Chamar ANTES de incrementar eating_count (`eating` = quantos já comiam) */
+static void class_admit(dh_classes_t* c, int cls, int eating) {
+    dh_class_stats_t* st = &c->stats[cls];
+    c->waiting[cls]--;
+    st->admitted++;
+    if (eating == 0) c->opener = cls;
+    else if (eating == 1) c->stats[c->opener].paired[cls]++;
+    if (c->num_classes == 0) return;
+
+    if (c->passed[cls] >= DH_CLASS_AGING) st->aged++;
+    c->passed[cls] = 0;
+    for (int k = 0; k < c->num_classes; k++) {
+        if (k != cls && c->waiting[k] > 0) c->passed[k]++;
+    }
+    c->vnow = c->vtime[cls];
+    c->vtime[cls] += DH_CLASS_VSCALE / (unsigned)st->weight;
+}
+
+/* dh_can_sit, e com lugares limitados só para a classe com a vez */
+static bool hall_may_sit(MutexHall* hall, int cls) {
+    const dh_state_t* s = &hall->base.state;
+    if (!dh_can_sit(s)) return false;
+    if (hall->base.classes.num_classes == 0 || s->capacity == 0) return true;
+    return class_next(&hall->base.classes) == cls;
+}
+
+/* Acorda um que espera para sentar, da classe com a vez */
+static void wake_next_sitter(MutexHall* hall) {
+    int cls = class_next(&hall->base.classes);
+    pthread_cond_signal(&hall->ok_to_sit[cls > 0 ? cls : 0]);
+}
+
+static void wake_all_sitters(MutexHall* hall) {
+    int n = hall->base.classes.num_classes;
+    for (int k = 0; k < (n > 0 ? n : 1); k++) pthread_cond_broadcast(&hall->ok_to_sit[k]);
+}
+
+/*
+ * Conclui todas as esperas assíncronas que a mudança de estado liberou.
+ * Retorna a lista (encadeada por `next`) para notificar fora do lock.
+ */
+static dh_waiter_t* hall_dispatch(MutexHall* hall) {
+    dh_state_t* s = &hall->base.state;
+    dh_waiter_t* done = NULL;
+    dh_waiter_t** tail = &done;
+    bool released = false;
+    bool progress = true;
+
+    while (progress) {
+        progress = false;
+
+        if (dh_pair_release(s, &hall->pair_exit)) {
+            released = true;
+            progress = true;
+        }
+
+        while (hall->async_enter.head) {
+            dh_status_t status;
+            if (hall_may_sit(hall, 0)) {
+                class_admit(&hall->base.classes, 0, s->eating_count);
+                s->eating_count++;
+                status = DH_OK;
+            } else if (dh_must_abort(s)) {
+                class_withdraw(&hall->base.classes, 0, true);
+                status = DH_ABORTED;
+            } else {
+                break;
+            }
+            s->waiting_to_eat--;
+
+            dh_waiter_t* w = queue_pop(&hall->async_enter);
+            if (status == DH_OK) DH_PROBE(enter_admitted, w->id, s);
+            else DH_PROBE(enter_abort, w->id, s);
+            w->status = status;
+            w->next = NULL;
+            *tail = w;
+            tail = &w->next;
+            progress = true;
+        }
+
+        while (hall->async_leave.head && dh_leave_released(s)) {
+            s->waiting_to_leave--;
+            s->eating_count--;
+
+            dh_waiter_t* w = queue_pop(&hall->async_leave);
+            DH_PROBE(leave_left, w->id, s);
+            w->status = DH_OK;
+            w->next = NULL;
+            *tail = w;
+            tail = &w->next;
+            progress = true;
+        }
+    }
+
+    // Esperas síncronas também podem ter sido liberadas
+    if (done || released) wake_next_sitter(hall);
+    return done;
+}
+
+/* Publica os contadores para dh_snapshot e solta o lock */
+static void hall_unlock(MutexHall* hall) {
+    dh_fuzz(DH_FUZZ_SIGNAL, &hall->base.state);
+    dh_publish(&hall->base);
+    pthread_mutex_unlock(&hall->lock);
+}
+
+/*
+ * Pega o lock. Com a contabilidade de esperas ligada, tenta antes sem
+ * bloquear: só a aquisição disputada conta como espera pelo lock.
+ * Gravando/reproduzindo o escalonamento (dh_sched.h), a aquisição é
+ * registrada (ou espera a sua vez no arquivo).
+ */
+static void hall_lock(MutexHall* hall, int id) {
+    dh_fuzz(DH_FUZZ_LOCK, NULL);
+    if (dh_sched_active()) {
+        bool turn = dh_sched_turn(id, DH_SCHED_LOCK);
+        pthread_mutex_lock(&hall->lock);
+        dh_sched_taken(id, DH_SCHED_LOCK, turn);
+        return;
+    }
+
+    dh_wait_mark m;
+    if (!dh_wait_begin(&m)) {
+        pthread_mutex_lock(&hall->lock);
+        return;
+    }
+    if (pthread_mutex_trylock(&hall->lock) == 0) return;
+    pthread_mutex_lock(&hall->lock);
+    dh_wait_end(&m, DH_WAIT_LOCK);
+}
+
+/*
+ * Reproduzindo, a condvar sai de cena: quem espera solta o lock e aguarda
+ * a sua vez de WAKE no arquivo. Pode voltar sem ser a vez (arquivo
+ * acabou); os chamadores já reconferem a condição em laço.
+ */
+static void hall_cond_wait(MutexHall* hall, pthread_cond_t* cond, int id) {
+    if (dh_sched_replaying()) {
+        pthread_mutex_unlock(&hall->lock);
+        bool turn = dh_sched_turn(id, DH_SCHED_WAKE);
+        pthread_mutex_lock(&hall->lock);
+        dh_sched_taken(id, DH_SCHED_WAKE, turn);
+        return;
+    }
+    pthread_cond_wait(cond, &hall->lock);
+    dh_sched_taken(id, DH_SCHED_WAKE, false);
+}
+
+/* Publica os contadores e espera na condvar (retomar o lock conta junto) */
+static void hall_wait(MutexHall* hall, pthread_cond_t* cond, dh_wait_reason_t reason, int id) {
+    dh_fuzz(DH_FUZZ_WAIT, &hall->base.state);
+    dh_publish(&hall->base);
+    dh_wait_mark m;
+    bool timed = dh_wait_begin(&m);
+    if (dh_sched_active()) hall_cond_wait(hall, cond, id);
+    else pthread_cond_wait(cond, &hall->lock);
+    if (timed) dh_wait_end(&m, reason);
+    dh_fuzz(DH_FUZZ_WAKE, &hall->base.state);
+}
+
+/* Notifica as esperas concluídas (chamar SEM o lock) */
+static void hall_notify(dh_waiter_t* done) {
+    while (done) {
+        dh_waiter_t* w = done;
+        done = w->next;
+
+        // O callback pode liberar/reutilizar o waiter: leia tudo antes
+        int event_fd = w->event_fd;
+        dh_callback_t callback = w->callback;
+        w->next = NULL;
+
+        if (callback) callback(w, w->status);
+        if (event_fd >= 0) {
+            uint64_t one = 1;
+            ssize_t n = write(event_fd, &one, sizeof(one));
+            (void)n; // EAGAIN só acontece se o contador saturar
+        }
+    }
+}
+
+/* Inicialização */
+static dh_hall_t* mutex_create(int total_students) {
+    MutexHall* hall = calloc(1, sizeof(*hall));
+    if (hall == NULL) return NULL;
+
+    dh_hall_init(&hall->base, &dh_engine_mutex, total_students);
+
+    pthread_mutex_init(&hall->lock, NULL);
+    for (int k = 0; k < DH_MAX_CLASSES; k++) pthread_cond_init(&hall->ok_to_sit[k], NULL);
+    return &hall->base;
+}
+
+static void mutex_destroy(dh_hall_t* base) {
+    MutexHall* hall = (MutexHall*)base;
+    pthread_mutex_destroy(&hall->lock);
+    for (int k = 0; k < DH_MAX_CLASSES; k++) pthread_cond_destroy(&hall->ok_to_sit[k]);
+    free(hall);
+}
+
+static bool mutex_enter_class(dh_hall_t* base, int id, int cls) {
+    MutexHall* hall = (MutexHall*)base;
+    dh_state_t* s = &base->state;
+    hall_lock(hall, id);
+
+    s->waiting_to_eat++;
+    class_arrive(&base->classes, cls);
+    DH_PROBE(enter_request, id, s);
+
+    while (true) {
+        // Condição 1: Posso sentar? (Alguém comendo OU tenho par na fila)
+        if (hall_may_sit(hall, cls)) {
+            break; // Sai do loop de espera e vai comer
+        }
+
+        // Condição 2: Devo desistir? (Deadlock prevention)
+        if (dh_must_abort(s)) {
+            s->waiting_to_eat--; // Sai da fila
+            class_withdraw(&base->classes, cls, true);
+            DH_PROBE(enter_abort, id, s);
+            hall_unlock(hall);
+            return false;
+        }
+
+        // Há lugar, mas a vez é de outra classe: passa o sinal adiante. A
+        // vez pode ser de uma espera assíncrona, que só hall_dispatch conclui.
+        if (dh_can_sit(s)) {
+            dh_waiter_t* done = hall_dispatch(hall);
+            if (done) {
+                hall_unlock(hall);
+                hall_notify(done);
+                hall_lock(hall, id);
+                continue;
+            }
+            wake_next_sitter(hall);
+        }
+
+        // Se não posso sentar nem preciso desistir, espero.
+        DH_PROBE(enter_wait, id, s);
+        hall_wait(hall, &hall->ok_to_sit[cls], DH_WAIT_PAIR, id);
+    }
+
+    s->waiting_to_eat--;
+    class_admit(&base->classes, cls, s->eating_count);
+    s->eating_count++;
+    DH_PROBE(enter_admitted, id, s);
+
+    // Com alguém comendo, todos os que esperam podem sentar: acorda todos
+    // de uma vez. As saídas rápidas não sinalizam ok_to_sit, então acordar
+    // um por vez viraria uma fila de trocas de contexto. Com lugares
+    // limitados acorda só o próximo, se ainda houver lugar (em cadeia).
+    if (s->waiting_to_eat > 0) {
+        if (dh_wake_all_sitters(s)) wake_all_sitters(hall);
+        else if (dh_seat_free(s)) wake_next_sitter(hall);
+    }
+    // 2 -> 3: quem estava na barreira de saída já pode ir (hall_dispatch).
+    // Tem que ser aqui, porque com >= 4 comendo as saídas são rápidas.
+    dh_waiter_t* done = hall_dispatch(hall);
+
+    hall_unlock(hall);
+    hall_notify(done);
+    return true;
+}
+
+static bool mutex_enter(dh_hall_t* base, int id) {
+    return mutex_enter_class(base, id, 0);
+}
+
+static void mutex_leave(dh_hall_t* base, int id) {
+    MutexHall* hall = (MutexHall*)base;
+    dh_state_t* s = &base->state;
+
+    // Refeitório cheio (>= 4 comendo): sai sem lock e sem acordar ninguém
+    if (dh_fast_leave(base, id)) return;
+
+    hall_lock(hall, id);
+    DH_PROBE(leave_request, id, s);
+
+    // Primeiro do par: quem liberar a barreira conclui a saída por mim.
+    // Gravando/reproduzindo, a volta da barreira é um turno PAIR.
+    if (s->eating_count == 2 && s->waiting_to_leave == 0) {
+        dh_pair_exit_t me;
+        dh_pair_register(s, &hall->pair_exit, &me, id);
+        DH_PROBE(leave_wait, id, s);
+        dh_fuzz(DH_FUZZ_WAIT, s);
+        hall_unlock(hall);
+        dh_pair_wait(&me);
+        if (dh_sched_active()) {
+            bool turn = dh_sched_turn(id, DH_SCHED_PAIR);
+            dh_sched_taken(id, DH_SCHED_PAIR, turn);
+        }
+        return;
+    }
+
+    // Segundo do par (ou sem barreira). O primeiro, se registrado, sai
+    // junto em hall_dispatch: os dois lugares vagam nesta seção crítica.
+    s->eating_count--;
+    DH_PROBE(leave_left, id, s);
+
+    wake_next_sitter(hall);
+    dh_waiter_t* done = hall_dispatch(hall);
+
+    hall_unlock(hall);
+    hall_notify(done);
+}
+
+static void mutex_done(dh_hall_t* base, int id) {
+    MutexHall* hall = (MutexHall*)base;
+    hall_lock(hall, id);
+    base->state.finished_students++;
+    DH_PROBE(done, id, &base->state);
+
+    // ACORDA TODOS: Quem estiver esperando em dh_enter precisa acordar
+    // para checar a condição de aborto (active_students < 2).
+    wake_all_sitters(hall);
+    dh_waiter_t* done = hall_dispatch(hall);
+
+    hall_unlock(hall);
+    hall_notify(done);
+}
+
+/* --- API não bloqueante --- */
+
+static dh_status_t mutex_try_leave(dh_hall_t* base, int id) {
+    MutexHall* hall = (MutexHall*)base;
+    dh_state_t* s = &base->state;
+    if (dh_fast_leave(base, id)) return DH_OK;
+
+    hall_lock(hall, id);
+    DH_PROBE(leave_request, id, s);
+
+    // Com 2 comendo, só sai na hora se o par já estiver na barreira
+    if (s->eating_count == 2 && s->waiting_to_leave == 0) {
+        hall_unlock(hall);
+        return DH_WOULDBLOCK;
+    }
+
+    s->eating_count--;
+    DH_PROBE(leave_left, id, s);
+
+    wake_next_sitter(hall);
+    dh_waiter_t* done = hall_dispatch(hall);
+
+    hall_unlock(hall);
+    hall_notify(done);
+    return DH_OK;
+}
+
+/*
+ * Mesmas regras de dh_enter, mas em vez de esperar na condvar o waiter
+ * entra na fila async_enter. `enqueue` = false é o modo "try": se tiver
+ * que esperar, desfaz a chegada e não registra nada.
+ */
+static dh_status_t hall_enter_nowait(MutexHall* hall, dh_waiter_t* waiter, bool enqueue) {
+    dh_state_t* s = &hall->base.state;
+    hall_lock(hall, waiter->id);
+
+    s->waiting_to_eat++;
+    class_arrive(&hall->base.classes, 0);
+    DH_PROBE(enter_request, waiter->id, s);
+
+    dh_status_t status;
+    if (hall_may_sit(hall, 0)) {
+        s->waiting_to_eat--;
+        class_admit(&hall->base.classes, 0, s->eating_count);
+        s->eating_count++;
+        DH_PROBE(enter_admitted, waiter->id, s);
+        if (s->waiting_to_eat > 0) {
+            if (dh_wake_all_sitters(s)) wake_all_sitters(hall);
+            else if (dh_seat_free(s)) wake_next_sitter(hall);
+        }
+        status = DH_OK;
+    } else if (dh_must_abort(s)) {
+        s->waiting_to_eat--;
+        class_withdraw(&hall->base.classes, 0, true);
+        DH_PROBE(enter_abort, waiter->id, s);
+        status = DH_ABORTED;
+    } else if (enqueue) {
+        if (dh_can_sit(s)) wake_next_sitter(hall); // A vez é de outra classe
+        DH_PROBE(enter_wait, waiter->id, s);
+        queue_push(&hall->async_enter, waiter);
+        status = DH_PENDING;
+    } else {
+        s->waiting_to_eat--;
+        class_withdraw(&hall->base.classes, 0, false);
+        status = DH_WOULDBLOCK;
+    }
+
+    dh_waiter_t* done = NULL;
+    if (status == DH_OK) done = hall_dispatch(hall);
+
+    hall_unlock(hall);
+    hall_notify(done);
+
+    if (status != DH_PENDING) waiter->status = status;
+    return status;
+}
+
+static dh_status_t mutex_try_enter(dh_hall_t* base, int id) {
+    dh_waiter_t probe = { .id = id, .event_fd = -1 };
+    return hall_enter_nowait((MutexHall*)base, &probe, false);
+}
+
+static dh_status_t mutex_enter_async(dh_hall_t* base, dh_waiter_t* waiter) {
+    return hall_enter_nowait((MutexHall*)base, waiter, true);
+}
+
+static dh_status_t mutex_leave_async(dh_hall_t* base, dh_waiter_t* waiter) {
+    MutexHall* hall = (MutexHall*)base;
+    dh_state_t* s = &base->state;
+    if (dh_fast_leave(base, waiter->id)) {
+        waiter->status = DH_OK;
+        return DH_OK;
+    }
+
+    hall_lock(hall, waiter->id);
+    DH_PROBE(leave_request, waiter->id, s);
+
+    if (s->eating_count == 2 && s->waiting_to_leave == 0) {
+        // Primeiro do par: espera na barreira sem bloquear a thread
+        s->waiting_to_leave++;
+        DH_PROBE(leave_wait, waiter->id, s);
+        queue_push(&hall->async_leave, waiter);
+        hall_unlock(hall);
+        return DH_PENDING;
+    }
+
+    s->eating_count--;
+    DH_PROBE(leave_left, waiter->id, s);
+
+    wake_next_sitter(hall);
+    dh_waiter_t* done = hall_dispatch(hall);
+
+    hall_unlock(hall);
+    hall_notify(done);
+
+    waiter->status = DH_OK;
+    return DH_OK;
+}
+
+const dh_engine_ops dh_engine_mutex = {
+    .name = "mutex",
+    .description = "pthread mutex + condvars (lógica original, suporta API assíncrona)",
+    .create = mutex_create,
+    .destroy = mutex_destroy,
+    .enter = mutex_enter,
+    .leave = mutex_leave,
+    .done = mutex_done,
+    .try_enter = mutex_try_enter,
+    .try_leave = mutex_try_leave,
+    .enter_async = mutex_enter_async,
+    .leave_async = mutex_leave_async,
+    .enter_class = mutex_enter_class,
+};
@@ -0,0 +1,167 @@
+/*
+ * dh_engine_rcl.c
+ * Motor "rcl" (delegação / remote core locking, Lozi et al.): uma thread
+ * servidora dedicada, fixada num núcleo, é a ÚNICA dona do estado do
+ * monitor. Os estudantes mandam enter/leave/done pelos seus slots (uma
+ * linha de cache por cliente, dh_slots.h) e o servidor fica varrendo os
+ * slots e aplicando os pedidos. O estado nunca sai do cache do servidor.
+ *
+ * O núcleo do servidor vem de $DH_SERVER_CPU (padrão: a última CPU
+ * permitida ao processo; um valor inválido ou fora das permitidas é
+ * avisado em stderr e ignorado). Ocioso por muito tempo, o servidor dorme num
+ * futex e o próximo cliente que publicar o acorda.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "dh_engine.h"
+#include "dh_slots.h"
+#include "dh_sync.h"
+
+/* Voltas sem trabalho antes de o servidor dormir */
+#define SERVER_IDLE_LIMIT 4096
+
+typedef struct {
+    dh_hall_t base;
+
+    _Alignas(DH_CACHE_LINE) atomic_int published;  // Conta publicações (futex do servidor)
+    atomic_int server_sleeping;
+    atomic_int stop;
+
+    dh_slot_list slots;
+    pthread_t server;
+    int server_cpu;            // -1 = sem fixação
+} RclHall;
+
+/* Núcleo do servidor: $DH_SERVER_CPU ou a última CPU permitida */
+static int pick_server_cpu(void) {
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return -1;
+
+    const char* env = getenv("DH_SERVER_CPU");
+    if (env && *env) {
+        char* end;
+        long cpu = strtol(env, &end, 10);
+        if (*end == '\0' && cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET((int)cpu, &set)) {
+            return (int)cpu;
+        }
+        fprintf(stderr, "libdininghall: DH_SERVER_CPU=%s não é uma CPU permitida; ignorado\n", env);
+    }
+
+    for (int cpu = CPU_SETSIZE - 1; cpu >= 0; cpu--) {
+        if (CPU_ISSET(cpu, &set)) return cpu;
+    }
+    return -1;
+}
+
+static void* rcl_server(void* arg) {
+    RclHall* hall = arg;
+
+    if (hall->server_cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(hall->server_cpu, &set);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err != 0) {
+            fprintf(stderr, "libdininghall: não fixou o servidor rcl na CPU %d: %s\n",
+                    hall->server_cpu, strerror(err));
+        }
+    }
+
+    int idle = 0;
+    while (!atomic_load_explicit(&hall->stop, memory_order_acquire)) {
+        int seen = atomic_load(&hall->published);
+        dh_state_t before = hall->base.state;
+        int completed = dh_slots_combine(&hall->base.state, &hall->slots);
+        // Só republica se algo mudou (chegadas contadas também contam)
+        if (memcmp(&before, &hall->base.state, sizeof(before)) != 0) dh_publish(&hall->base);
+        if (completed > 0 || atomic_load(&hall->published) != seen) {
+            idle = 0;
+            continue;
+        }
+
+        // Nada novo: pedidos pendentes só andam quando chegar outro pedido
+        if (++idle < SERVER_IDLE_LIMIT) {
+            dh_spin_backoff(&idle);
+            continue;
+        }
+
+        atomic_store(&hall->server_sleeping, 1);
+        if (atomic_load(&hall->published) == seen && !atomic_load(&hall->stop)) {
+            dh_futex_wait(&hall->published, seen, NULL);
+        }
+        atomic_store(&hall->server_sleeping, 0);
+        idle = 0;
+    }
+    return NULL;
+}
+
+static int rcl_request(dh_hall_t* base, dh_op_t op, int id) {
+    RclHall* hall = (RclHall*)base;
+    dh_slot* slot = dh_slot_for_thread(&hall->slots);
+    if (slot == NULL) dh_slot_alloc_failed(base);
+
+    dh_slot_publish(slot, op, id);
+    atomic_fetch_add(&hall->published, 1);
+    if (atomic_load(&hall->server_sleeping)) dh_futex_wake(&hall->published, 1);
+    return dh_slot_wait(slot);
+}
+
+static dh_hall_t* rcl_create(int total_students) {
+    RclHall* hall = aligned_alloc(DH_CACHE_LINE, sizeof(RclHall));
+    if (hall == NULL) return NULL;
+
+    dh_hall_init(&hall->base, &dh_engine_rcl, total_students);
+    atomic_init(&hall->published, 0);
+    atomic_init(&hall->server_sleeping, 0);
+    atomic_init(&hall->stop, 0);
+    dh_slots_init(&hall->slots);
+    hall->server_cpu = pick_server_cpu();
+
+    if (pthread_create(&hall->server, NULL, rcl_server, hall) != 0) {
+        free(hall);
+        return NULL;
+    }
+    return &hall->base;
+}
+
+static void rcl_destroy(dh_hall_t* base) {
+    RclHall* hall = (RclHall*)base;
+
+    atomic_store(&hall->stop, 1);
+    atomic_fetch_add(&hall->published, 1);
+    dh_futex_wake(&hall->published, 1);
+    pthread_join(hall->server, NULL);
+
+    dh_slots_free(&hall->slots);
+    free(hall);
+}
+
+static bool rcl_enter(dh_hall_t* hall, int id) {
+    return rcl_request(hall, DH_OP_ENTER, id) == 1;
+}
+
+static void rcl_leave(dh_hall_t* hall, int id) {
+    rcl_request(hall, DH_OP_LEAVE, id);
+}
+
+static void rcl_done(dh_hall_t* hall, int id) {
+    rcl_request(hall, DH_OP_DONE, id);
+}
+
+const dh_engine_ops dh_engine_rcl = {
+    .name = "rcl",
+    .description = "delegação: thread servidora fixada num núcleo é dona do estado",
+    .create = rcl_create,
+    .destroy = rcl_destroy,
+    .enter = rcl_enter,
+    .leave = rcl_leave,
+    .done = rcl_done,
+};
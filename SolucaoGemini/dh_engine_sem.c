@@ -0,0 +1,156 @@
+/*
+ * dh_engine_sem.c
+ * Motor "sem": solução clássica só com semáforos POSIX, usando a técnica
+ * de "passagem de bastão" (Andrews). O semáforo `entry` funciona como
+ * mutex; quem espera bloqueia no semáforo da sua condição e é acordado
+ * JÁ com o bastão (a exclusão mútua) por quem tornou a condição
+ * verdadeira. Assim não há re-checagem em laço como nas condvars.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <semaphore.h>
+
+#include "dh_engine.h"
+
+typedef struct {
+    dh_hall_t base;
+
+    sem_t entry;               // Bastão (exclusão mútua), começa em 1
+    sem_t sit_q;               // Onde esperam os que não podem sentar
+    sem_t leave_q;             // Onde espera o primeiro do par na barreira
+
+    int blocked_sit;           // Threads paradas em sit_q
+    int blocked_leave;         // Threads paradas em leave_q
+} SemHall;
+
+/*
+ * sem_wait sem ser interrompido por sinais. Com a contabilidade de esperas
+ * ligada, tenta antes sem bloquear: só a espera de verdade é contada.
+ */
+static void sem_acquire(sem_t* sem, dh_wait_reason_t reason) {
+    if (reason == DH_WAIT_LOCK) dh_fuzz(DH_FUZZ_LOCK, NULL);
+    dh_wait_mark m;
+    if (dh_wait_begin(&m)) {
+        if (sem_trywait(sem) == 0) return;
+        while (sem_wait(sem) != 0 && errno == EINTR) {}
+        dh_wait_end(&m, reason);
+        return;
+    }
+    while (sem_wait(sem) != 0 && errno == EINTR) {}
+}
+
+/*
+ * Passa o bastão: acorda UMA thread cuja condição agora é verdadeira
+ * (ela herda a exclusão mútua) ou, se não houver, libera `entry`.
+ */
+static void sem_release_baton(SemHall* hall) {
+    const dh_state_t* s = &hall->base.state;
+
+    dh_fuzz(DH_FUZZ_SIGNAL, s);
+    dh_publish(&hall->base);           // Ainda com o bastão
+
+    if (hall->blocked_sit > 0 && (dh_can_sit(s) || dh_must_abort(s))) {
+        hall->blocked_sit--;
+        sem_post(&hall->sit_q);
+    } else if (hall->blocked_leave > 0 && dh_leave_released(s)) {
+        hall->blocked_leave--;
+        sem_post(&hall->leave_q);
+    } else {
+        sem_post(&hall->entry);
+    }
+}
+
+static dh_hall_t* sem_engine_create(int total_students) {
+    SemHall* hall = calloc(1, sizeof(*hall));
+    if (hall == NULL) return NULL;
+
+    dh_hall_init(&hall->base, &dh_engine_sem, total_students);
+    sem_init(&hall->entry, 0, 1);
+    sem_init(&hall->sit_q, 0, 0);
+    sem_init(&hall->leave_q, 0, 0);
+    return &hall->base;
+}
+
+static void sem_engine_destroy(dh_hall_t* base) {
+    SemHall* hall = (SemHall*)base;
+    sem_destroy(&hall->entry);
+    sem_destroy(&hall->sit_q);
+    sem_destroy(&hall->leave_q);
+    free(hall);
+}
+
+static bool sem_engine_enter(dh_hall_t* base, int id) {
+    SemHall* hall = (SemHall*)base;
+    dh_state_t* s = &base->state;
+    sem_acquire(&hall->entry, DH_WAIT_LOCK);
+
+    s->waiting_to_eat++;
+    DH_PROBE(enter_request, id, s);
+
+    if (!dh_can_sit(s) && !dh_must_abort(s)) {
+        // Minha chegada sozinha não libera ninguém: devolve `entry` direto
+        DH_PROBE(enter_wait, id, s);
+        hall->blocked_sit++;
+        dh_fuzz(DH_FUZZ_WAIT, s);
+        dh_publish(&hall->base);
+        sem_post(&hall->entry);
+        sem_acquire(&hall->sit_q, DH_WAIT_PAIR);   // Acordo com o bastão e a condição garantida
+        dh_fuzz(DH_FUZZ_WAKE, s);
+    }
+
+    bool sat = dh_can_sit(s);        // Senão: abortar (sem parceiros possíveis)
+    s->waiting_to_eat--;
+    if (sat) s->eating_count++;
+    if (sat) DH_PROBE(enter_admitted, id, s);
+    else DH_PROBE(enter_abort, id, s);
+
+    sem_release_baton(hall);
+    return sat;
+}
+
+static void sem_engine_leave(dh_hall_t* base, int id) {
+    SemHall* hall = (SemHall*)base;
+    dh_state_t* s = &base->state;
+    sem_acquire(&hall->entry, DH_WAIT_LOCK);
+    DH_PROBE(leave_request, id, s);
+
+    if (s->eating_count == 2) {
+        s->waiting_to_leave++;
+        if (!dh_leave_released(s)) {
+            DH_PROBE(leave_wait, id, s);
+            hall->blocked_leave++;
+            dh_fuzz(DH_FUZZ_WAIT, s);
+            dh_publish(&hall->base);
+            sem_post(&hall->entry);
+            sem_acquire(&hall->leave_q, DH_WAIT_BARRIER);
+            dh_fuzz(DH_FUZZ_WAKE, s);
+        }
+        s->waiting_to_leave--;
+    }
+
+    s->eating_count--;
+    DH_PROBE(leave_left, id, s);
+    sem_release_baton(hall);
+}
+
+static void sem_engine_done(dh_hall_t* base, int id) {
+    SemHall* hall = (SemHall*)base;
+    sem_acquire(&hall->entry, DH_WAIT_LOCK);
+    base->state.finished_students++;
+    DH_PROBE(done, id, &base->state);
+    // Se alguém precisar abortar, o bastão passa de um em um (cascata)
+    sem_release_baton(hall);
+}
+
+const dh_engine_ops dh_engine_sem = {
+    .name = "sem",
+    .description = "semáforos POSIX com passagem de bastão (solução clássica)",
+    .create = sem_engine_create,
+    .destroy = sem_engine_destroy,
+    .enter = sem_engine_enter,
+    .leave = sem_engine_leave,
+    .done = sem_engine_done,
+};
@@ -0,0 +1,148 @@
+/*
+ * dh_engine_spin.c
+ * Motor "spin": nenhuma chamada de sistema no caminho comum. O estado é
+ * protegido por um spinlock TTAS e as "condições" são contadores de
+ * geração: quem espera solta o lock e gira até a geração mudar
+ * (cedendo a CPU depois de DH_SPIN_LIMIT voltas).
+ * Bom com poucos estudantes por núcleo; péssimo com superlotação.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "dh_engine.h"
+#include "dh_sync.h"
+
+typedef struct {
+    dh_hall_t base;
+
+    dh_spinlock lock;
+    atomic_int sit_gen;        // Muda quando alguém pode ter liberado um assento
+    atomic_int leave_gen;      // Muda quando a barreira de saída pode ter aberto
+} SpinHall;
+
+/* Publica os contadores para dh_snapshot e solta o lock */
+static void spin_unlock(SpinHall* hall) {
+    dh_fuzz(DH_FUZZ_SIGNAL, &hall->base.state);
+    dh_publish(&hall->base);
+    dh_spin_unlock(&hall->lock);
+}
+
+/*
+ * Pega o lock. Com a contabilidade de esperas ligada, uma primeira troca
+ * que já consegue o lock não conta como espera.
+ */
+static void spin_lock(SpinHall* hall) {
+    dh_fuzz(DH_FUZZ_LOCK, NULL);
+    dh_wait_mark m;
+    if (!dh_wait_begin(&m)) {
+        dh_spin_lock(&hall->lock);
+        return;
+    }
+    if (!atomic_exchange_explicit(&hall->lock.locked, 1, memory_order_acquire)) return;
+    dh_spin_lock(&hall->lock);
+    dh_wait_end(&m, DH_WAIT_LOCK);
+}
+
+/* Solta o lock, gira até `gen` mudar e retoma o lock */
+static void spin_wait(SpinHall* hall, atomic_int* gen, dh_wait_reason_t reason) {
+    dh_fuzz(DH_FUZZ_WAIT, &hall->base.state);
+    int seen = atomic_load_explicit(gen, memory_order_relaxed);
+    spin_unlock(hall);
+
+    dh_wait_mark m;
+    bool timed = dh_wait_begin(&m);
+    int spins = 0;
+    while (atomic_load_explicit(gen, memory_order_acquire) == seen) {
+        dh_spin_backoff(&spins);
+    }
+    dh_spin_lock(&hall->lock);
+    if (timed) dh_wait_end(&m, reason);
+    dh_fuzz(DH_FUZZ_WAKE, &hall->base.state);
+}
+
+static void spin_notify(atomic_int* gen) {
+    atomic_fetch_add_explicit(gen, 1, memory_order_release);
+}
+
+static dh_hall_t* spin_create(int total_students) {
+    SpinHall* hall = calloc(1, sizeof(*hall));
+    if (hall == NULL) return NULL;
+    dh_hall_init(&hall->base, &dh_engine_spin, total_students);
+    return &hall->base;
+}
+
+static void spin_destroy(dh_hall_t* base) {
+    free(base);
+}
+
+static bool spin_enter(dh_hall_t* base, int id) {
+    SpinHall* hall = (SpinHall*)base;
+    dh_state_t* s = &base->state;
+    spin_lock(hall);
+
+    s->waiting_to_eat++;
+    DH_PROBE(enter_request, id, s);
+
+    while (!dh_can_sit(s)) {
+        if (dh_must_abort(s)) {
+            s->waiting_to_eat--;
+            DH_PROBE(enter_abort, id, s);
+            spin_unlock(hall);
+            return false;
+        }
+        DH_PROBE(enter_wait, id, s);
+        spin_wait(hall, &hall->sit_gen, DH_WAIT_PAIR);
+    }
+
+    s->waiting_to_eat--;
+    s->eating_count++;
+    DH_PROBE(enter_admitted, id, s);
+
+    spin_notify(&hall->sit_gen);
+    spin_unlock(hall);
+    return true;
+}
+
+static void spin_leave(dh_hall_t* base, int id) {
+    SpinHall* hall = (SpinHall*)base;
+    dh_state_t* s = &base->state;
+    spin_lock(hall);
+    DH_PROBE(leave_request, id, s);
+
+    if (s->eating_count == 2) {
+        s->waiting_to_leave++;
+        DH_PROBE(leave_wait, id, s);
+        while (s->waiting_to_leave < 2 && s->eating_count == 2) {
+            spin_wait(hall, &hall->leave_gen, DH_WAIT_BARRIER);
+        }
+        s->waiting_to_leave--;
+    }
+
+    s->eating_count--;
+    DH_PROBE(leave_left, id, s);
+
+    spin_notify(&hall->leave_gen);
+    spin_notify(&hall->sit_gen);
+    spin_unlock(hall);
+}
+
+static void spin_done(dh_hall_t* base, int id) {
+    SpinHall* hall = (SpinHall*)base;
+    spin_lock(hall);
+    base->state.finished_students++;
+    DH_PROBE(done, id, &base->state);
+    spin_notify(&hall->sit_gen);
+    spin_unlock(hall);
+}
+
+const dh_engine_ops dh_engine_spin = {
+    .name = "spin",
+    .description = "spinlock TTAS + espera ativa por geração (sem syscalls)",
+    .create = spin_create,
+    .destroy = spin_destroy,
+    .enter = spin_enter,
+    .leave = spin_leave,
+    .done = spin_done,
+};
@@ -0,0 +1,126 @@
+/*
+ * dh_fuzz.c
+ * Perturbação do escalonamento guiada por cobertura (ver dh_fuzz.h).
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include "dh_fuzz.h"
+#include "dh_engine.h"
+
+/* Estado abstrato: eating x waiting_to_eat x waiting_to_leave x ativos x ponto */
+#define FUZZ_EAT     5
+#define FUZZ_WTE     4
+#define FUZZ_WTL     3
+#define FUZZ_ACTIVE  4
+#define FUZZ_STATES  (FUZZ_EAT * FUZZ_WTE * FUZZ_WTL * FUZZ_ACTIVE * DH_FUZZ_NUM_POINTS)
+
+atomic_bool dh_fuzz_on = false;
+
+static struct {
+    uint64_t seed;
+    int percent;
+    atomic_uint generation;    // Muda a cada enable: threads ressemeiam
+    atomic_uint next_thread;
+
+    atomic_uint hits[FUZZ_STATES];
+    atomic_ullong points;
+    atomic_ullong perturbed;
+} fz;
+
+static __thread struct {
+    uint64_t rng;
+    unsigned generation;
+} fuzz_thread;
+
+static uint64_t fuzz_next(void) {
+    // xorshift64*
+    uint64_t x = fuzz_thread.rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    fuzz_thread.rng = x;
+    return x * 0x2545F4914F6CDD1Dull;
+}
+
+static void fuzz_seed_thread(unsigned generation) {
+    // Semente da rodada misturada com a ordem de chegada desta thread
+    unsigned n = atomic_fetch_add_explicit(&fz.next_thread, 1, memory_order_relaxed);
+    fuzz_thread.rng = (fz.seed ^ (0x9E3779B97F4A7C15ull * (n + 1))) | 1;
+    fuzz_thread.generation = generation;
+}
+
+static int clamp(int v, int max) {
+    return v < 0 ? 0 : v >= max ? max - 1 : v;
+}
+
+static unsigned state_key(int point, const dh_state_t* s) {
+    unsigned k = (unsigned)clamp(s->eating_count, FUZZ_EAT);
+    k = k * FUZZ_WTE + (unsigned)clamp(s->waiting_to_eat, FUZZ_WTE);
+    k = k * FUZZ_WTL + (unsigned)clamp(s->waiting_to_leave, FUZZ_WTL);
+    k = k * FUZZ_ACTIVE + (unsigned)clamp(s->total_students - s->finished_students, FUZZ_ACTIVE);
+    return k * DH_FUZZ_NUM_POINTS + (unsigned)point;
+}
+
+/* Uma perturbação: ceder a CPU, girar um pouco ou dormir alguns µs */
+static void perturb(void) {
+    uint64_t r = fuzz_next();
+    switch (r % 3) {
+    case 0:
+        sched_yield();
+        break;
+    case 1:
+        for (unsigned i = (unsigned)(r >> 8) % 2000; i > 0; i--) dh_cpu_relax();
+        break;
+    default: {
+        struct timespec ts = { 0, (long)((r >> 8) % 200 + 1) * 1000 };
+        nanosleep(&ts, NULL);
+        break;
+    }
+    }
+}
+
+void dh_fuzz_point(int point, const dh_state_t* s) {
+    unsigned generation = atomic_load_explicit(&fz.generation, memory_order_acquire);
+    if (fuzz_thread.generation != generation) fuzz_seed_thread(generation);
+    atomic_fetch_add_explicit(&fz.points, 1, memory_order_relaxed);
+
+    // Chance em milésimos: cheia num estado novo, cai com as visitas
+    unsigned chance = (unsigned)fz.percent * 10;
+    if (s) {
+        unsigned hits = atomic_fetch_add_explicit(&fz.hits[state_key(point, s)], 1,
+                                                  memory_order_relaxed);
+        chance = chance * 16 / (16 + hits);
+    } else {
+        chance /= 4; // LOCK: sem estado (ainda sem o lock)
+    }
+
+    if (fuzz_next() % 1000 < chance) {
+        atomic_fetch_add_explicit(&fz.perturbed, 1, memory_order_relaxed);
+        perturb();
+    }
+}
+
+void dh_fuzz_enable(uint64_t seed, int percent) {
+    fz.seed = seed;
+    fz.percent = percent < 0 ? 0 : percent > 100 ? 100 : percent;
+    atomic_store(&fz.next_thread, 0);
+    atomic_fetch_add_explicit(&fz.generation, 1, memory_order_release);
+    atomic_store(&dh_fuzz_on, true);
+}
+
+void dh_fuzz_disable(void) {
+    atomic_store(&dh_fuzz_on, false);
+}
+
+void dh_fuzz_stats(dh_fuzz_stats_t* out) {
+    memset(out, 0, sizeof(*out));
+    for (int k = 0; k < FUZZ_STATES; k++) {
+        if (atomic_load_explicit(&fz.hits[k], memory_order_relaxed) > 0) out->states++;
+    }
+    out->possible = FUZZ_STATES;
+    out->points = atomic_load(&fz.points);
+    out->perturbed = atomic_load(&fz.perturbed);
+}
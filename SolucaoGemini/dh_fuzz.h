@@ -0,0 +1,57 @@
+/*
+ * dh_fuzz.h
+ * Perturbação do escalonamento para achar intercalações raras
+ * (dining_hall -F). Com 10-50 ms de sono entre as chamadas, as threads
+ * quase nunca se cruzam dentro do monitor; o fuzzer injeta sched_yield,
+ * giros curtos e pausas de microssegundos nos pontos de decisão dos
+ * motores:
+ *
+ *   LOCK    antes de pegar o lock do monitor
+ *   WAIT    com o lock, logo antes de esperar (condvar, fila, geração)
+ *   WAKE    com o lock, logo depois de acordar
+ *   SIGNAL  com o lock, depois de acordar os outros e antes de soltar
+ *
+ * Guiado por cobertura: cada ponto com o lock vê um estado abstrato do
+ * monitor (eating 0..4+, waiting_to_eat 0..3+, waiting_to_leave 0..2+,
+ * ativos 0..3+, ponto). Estados pouco visitados são perturbados com mais
+ * probabilidade, estados batidos quase nunca, e a cobertura acumula entre
+ * as rodadas do processo. Cada thread sorteia com um xorshift próprio,
+ * semeado pela semente dada e pela ordem de chegada da thread.
+ *
+ * Motores com ganchos: mutex, sem, futex, mcs, clh, cohort e spin (fc/rcl
+ * delegam a seção crítica e não têm esses pontos). Desligado, cada ponto
+ * custa uma leitura relaxada.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#ifndef DH_FUZZ_H
+#define DH_FUZZ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    unsigned states;           // Estados abstratos já visitados
+    unsigned possible;         // Total de estados abstratos
+    unsigned long long points; // Pontos de perturbação atingidos
+    unsigned long long perturbed; // Quantos foram perturbados
+} dh_fuzz_stats_t;
+
+/*
+ * Liga o fuzzer (ou troca a semente). `percent` é a chance de perturbar
+ * um estado nunca visto; cai conforme o estado se repete.
+ */
+void dh_fuzz_enable(uint64_t seed, int percent);
+void dh_fuzz_disable(void);
+
+void dh_fuzz_stats(dh_fuzz_stats_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DH_FUZZ_H */
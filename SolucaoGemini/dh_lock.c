@@ -0,0 +1,271 @@
+/*
+ * dh_lock.c
+ * Implementação dos locks MCS, CLH e de coorte NUMA (ver dh_lock.h).
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "dh_lock.h"
+
+/* Voltas girando no nó antes de dormir no futex */
+#define QNODE_SPIN_LIMIT 512
+
+/* --- Espera/liberação de um nó de fila --- */
+
+/* Espera `node->locked` virar 0: gira, depois dorme (marcando 2) */
+static void qnode_wait(dh_qnode* node) {
+    for (int spins = 0; spins < QNODE_SPIN_LIMIT; spins++) {
+        if (atomic_load_explicit(&node->locked, memory_order_acquire) == 0) return;
+        dh_cpu_relax();
+    }
+
+    int expected = 1;
+    atomic_compare_exchange_strong(&node->locked, &expected, 2);
+    while (atomic_load_explicit(&node->locked, memory_order_acquire) != 0) {
+        dh_futex_wait(&node->locked, 2, NULL);
+    }
+}
+
+/* Libera quem espera em `node` (acorda se ele estiver dormindo) */
+static void qnode_grant(dh_qnode* node) {
+    if (atomic_exchange_explicit(&node->locked, 0, memory_order_release) == 2) {
+        dh_futex_wake(&node->locked, 1);
+    }
+}
+
+/* --- MCS --- */
+
+/* Uma thread nunca segura dois locks de monitor ao mesmo tempo: um nó basta */
+static __thread dh_qnode mcs_node;
+
+static void mcs_acquire(dh_mcs_lock* lock) {
+    dh_qnode* node = &mcs_node;
+    atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+    atomic_store_explicit(&node->locked, 1, memory_order_relaxed);
+
+    dh_qnode* pred = atomic_exchange_explicit(&lock->tail, node, memory_order_acq_rel);
+    if (pred) {
+        atomic_store_explicit(&pred->next, node, memory_order_release);
+        qnode_wait(node);
+    }
+    lock->holder = node;
+}
+
+/* Há alguém na fila atrás do dono? */
+static bool mcs_has_waiter(dh_mcs_lock* lock) {
+    return atomic_load_explicit(&lock->holder->next, memory_order_acquire) != NULL ||
+           atomic_load_explicit(&lock->tail, memory_order_acquire) != lock->holder;
+}
+
+static void mcs_release(dh_mcs_lock* lock) {
+    dh_qnode* node = lock->holder;
+    dh_qnode* succ = atomic_load_explicit(&node->next, memory_order_acquire);
+
+    if (succ == NULL) {
+        dh_qnode* expected = node;
+        if (atomic_compare_exchange_strong(&lock->tail, &expected, NULL)) return;
+        // Alguém entrou na fila mas ainda não se ligou a nós
+        while ((succ = atomic_load_explicit(&node->next, memory_order_acquire)) == NULL) {
+            dh_cpu_relax();
+        }
+    }
+    qnode_grant(succ);
+}
+
+/* --- CLH --- */
+
+/*
+ * No CLH cada thread "herda" o nó do antecessor ao soltar o lock, então
+ * o nó da thread muda de dono ao longo do tempo. Invariante: em repouso,
+ * o lock é dono do nó em `tail` e cada thread é dona do seu clh_node.
+ */
+static __thread dh_qnode* clh_node;
+static pthread_key_t clh_key;
+static pthread_once_t clh_key_once = PTHREAD_ONCE_INIT;
+
+static void clh_free_node(void* node) { free(node); }
+static void clh_make_key(void) { pthread_key_create(&clh_key, clh_free_node); }
+
+static dh_qnode* clh_new_node(void) {
+    dh_qnode* node = aligned_alloc(DH_LOCK_CACHE_LINE, sizeof(dh_qnode));
+    if (node) memset(node, 0, sizeof(*node));
+    return node;
+}
+
+static void clh_acquire(dh_clh_lock* lock) {
+    if (clh_node == NULL) {
+        pthread_once(&clh_key_once, clh_make_key);
+        clh_node = clh_new_node();
+        pthread_setspecific(clh_key, clh_node);
+    }
+
+    dh_qnode* node = clh_node;
+    atomic_store_explicit(&node->locked, 1, memory_order_relaxed);
+    dh_qnode* pred = atomic_exchange_explicit(&lock->tail, node, memory_order_acq_rel);
+    qnode_wait(pred);
+
+    lock->holder = node;
+    lock->holder_pred = pred;
+}
+
+static void clh_release(dh_clh_lock* lock) {
+    dh_qnode* node = lock->holder;
+
+    // O nó do antecessor passa a ser meu; o meu fica com o sucessor/lock
+    clh_node = lock->holder_pred;
+    pthread_setspecific(clh_key, clh_node);
+    qnode_grant(node);
+}
+
+/* --- Coorte NUMA --- */
+
+/* Lê /sys/devices/system/node/nodeN/cpulist (ex.: "0-3,8-11") */
+static int read_cpulist(int node, int* cpu_node, int num_cpus) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE* f = fopen(path, "r");
+    if (f == NULL) return -1;
+
+    int lo, hi;
+    char sep;
+    while (fscanf(f, "%d", &lo) == 1) {
+        hi = lo;
+        if (fscanf(f, "%c", &sep) == 1 && sep == '-') {
+            if (fscanf(f, "%d", &hi) != 1) break;
+            if (fscanf(f, "%c", &sep) != 1) sep = '\n';
+        }
+        for (int cpu = lo; cpu <= hi && cpu < num_cpus; cpu++) cpu_node[cpu] = node;
+        if (sep != ',') break;
+    }
+    fclose(f);
+    return 0;
+}
+
+/*
+ * Mapa CPU -> nó. Com $DH_COHORT_NODES=k (k > 1) simula k soquetes
+ * dividindo as CPUs em k blocos contíguos; senão usa os nós NUMA reais.
+ */
+static int cohort_topology(dh_cohort_lock* lock) {
+    lock->num_cpus = (int)sysconf(_SC_NPROCESSORS_CONF);
+    if (lock->num_cpus < 1) lock->num_cpus = 1;
+    lock->cpu_node = calloc(lock->num_cpus, sizeof(int));
+    if (lock->cpu_node == NULL) return -1;
+
+    const char* env = getenv("DH_COHORT_NODES");
+    int simulated = env ? atoi(env) : 0;
+    if (simulated > 1) {
+        for (int cpu = 0; cpu < lock->num_cpus; cpu++) {
+            lock->cpu_node[cpu] = (int)((long)cpu * simulated / lock->num_cpus);
+        }
+        lock->num_nodes = simulated;
+        return 0;
+    }
+
+    lock->num_nodes = 0;
+    while (read_cpulist(lock->num_nodes, lock->cpu_node, lock->num_cpus) == 0) {
+        lock->num_nodes++;
+    }
+    if (lock->num_nodes == 0) lock->num_nodes = 1;
+    return 0;
+}
+
+static int cohort_init(dh_cohort_lock* lock) {
+    memset(lock, 0, sizeof(*lock));
+    if (cohort_topology(lock) != 0) return -1;
+
+    lock->locals = aligned_alloc(DH_LOCK_CACHE_LINE, sizeof(dh_cohort_local) * lock->num_nodes);
+    if (lock->locals == NULL) {
+        free(lock->cpu_node);
+        return -1;
+    }
+    memset(lock->locals, 0, sizeof(dh_cohort_local) * lock->num_nodes);
+    return 0;
+}
+
+static void cohort_acquire(dh_cohort_lock* lock) {
+    int cpu = sched_getcpu();
+    int node = (cpu >= 0 && cpu < lock->num_cpus) ? lock->cpu_node[cpu] : 0;
+    dh_cohort_local* local = &lock->locals[node];
+
+    mcs_acquire(&local->mcs);
+    if (!local->global_owned) {
+        dh_futex_mutex_lock(&lock->global);
+        local->global_owned = 1;
+    }
+    // A thread pode migrar de CPU: o release usa o nó gravado aqui
+    lock->holder = local;
+}
+
+static void cohort_release(dh_cohort_lock* lock) {
+    dh_cohort_local* local = lock->holder;
+
+    if (local->passes < DH_COHORT_MAX_PASS && mcs_has_waiter(&local->mcs)) {
+        // Repassa o lock global para o próximo do mesmo nó
+        local->passes++;
+    } else {
+        local->passes = 0;
+        local->global_owned = 0;
+        dh_futex_mutex_unlock(&lock->global);
+    }
+    mcs_release(&local->mcs);
+}
+
+/* --- Despacho --- */
+
+int dh_lock_init(dh_lock* lock, dh_lock_kind kind) {
+    memset(lock, 0, sizeof(*lock));
+    lock->kind = kind;
+
+    switch (kind) {
+    case DH_LOCK_FUTEX:
+    case DH_LOCK_MCS:
+        return 0;
+    case DH_LOCK_CLH: {
+        dh_qnode* dummy = clh_new_node();   // Nó inicial, já liberado
+        if (dummy == NULL) return -1;
+        atomic_init(&lock->u.clh.tail, dummy);
+        return 0;
+    }
+    case DH_LOCK_COHORT:
+        return cohort_init(&lock->u.cohort);
+    }
+    return -1;
+}
+
+void dh_lock_destroy(dh_lock* lock) {
+    switch (lock->kind) {
+    case DH_LOCK_CLH:
+        free(atomic_load(&lock->u.clh.tail));
+        break;
+    case DH_LOCK_COHORT:
+        free(lock->u.cohort.locals);
+        free(lock->u.cohort.cpu_node);
+        break;
+    default:
+        break;
+    }
+}
+
+void dh_lock_acquire(dh_lock* lock) {
+    switch (lock->kind) {
+    case DH_LOCK_FUTEX:  dh_futex_mutex_lock(&lock->u.futex); break;
+    case DH_LOCK_MCS:    mcs_acquire(&lock->u.mcs); break;
+    case DH_LOCK_CLH:    clh_acquire(&lock->u.clh); break;
+    case DH_LOCK_COHORT: cohort_acquire(&lock->u.cohort); break;
+    }
+}
+
+void dh_lock_release(dh_lock* lock) {
+    switch (lock->kind) {
+    case DH_LOCK_FUTEX:  dh_futex_mutex_unlock(&lock->u.futex); break;
+    case DH_LOCK_MCS:    mcs_release(&lock->u.mcs); break;
+    case DH_LOCK_CLH:    clh_release(&lock->u.clh); break;
+    case DH_LOCK_COHORT: cohort_release(&lock->u.cohort); break;
+    }
+}
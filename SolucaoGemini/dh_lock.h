@@ -0,0 +1,108 @@
+/*
+ * dh_lock.h
+ * Locks intercambiáveis para o monitor dos motores baseados em lock:
+ *   - futex:  mutex de futex (dh_sync.h), o equivalente ao pthread_mutex;
+ *   - mcs:    fila MCS (cada thread gira na PRÓPRIA linha de cache);
+ *   - clh:    fila CLH (cada thread gira no nó do antecessor);
+ *   - cohort: lock de coorte NUMA (C-MCS): um MCS local por nó/soquete
+ *             e um lock global; o lock global é repassado dentro do
+ *             mesmo nó até DH_COHORT_MAX_PASS vezes antes de ser solto.
+ *
+ * Os locks em fila giram um pouco e depois dormem num futex no próprio
+ * nó, então funcionam mesmo com mais threads do que núcleos.
+ * A variável de condição dh_lock_cond funciona com qualquer um deles.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#ifndef DH_LOCK_H
+#define DH_LOCK_H
+
+#include <stdatomic.h>
+
+#include "dh_sync.h"
+
+#define DH_LOCK_CACHE_LINE 64
+
+/* Quantas vezes o lock global passa de mão dentro do mesmo nó */
+#define DH_COHORT_MAX_PASS 64
+
+typedef enum {
+    DH_LOCK_FUTEX,
+    DH_LOCK_MCS,
+    DH_LOCK_CLH,
+    DH_LOCK_COHORT
+} dh_lock_kind;
+
+/* Nó de fila (MCS/CLH): uma linha de cache por thread */
+typedef struct dh_qnode {
+    _Alignas(DH_LOCK_CACHE_LINE) atomic_int locked;   // 1 = esperando, 2 = dormindo, 0 = liberado
+    _Atomic(struct dh_qnode*) next;                   // Só MCS
+} dh_qnode;
+
+typedef struct {
+    _Atomic(dh_qnode*) tail;
+    dh_qnode* holder;          // Nó de quem tem o lock (usado no release)
+} dh_mcs_lock;
+
+typedef struct {
+    _Atomic(dh_qnode*) tail;
+    dh_qnode* holder;
+    dh_qnode* holder_pred;     // Nó que o dono herda ao soltar
+} dh_clh_lock;
+
+/* Parte local (um por nó NUMA) do lock de coorte */
+typedef struct {
+    _Alignas(DH_LOCK_CACHE_LINE) dh_mcs_lock mcs;
+    int global_owned;          // A coorte já tem o lock global
+    int passes;                // Repasses locais seguidos
+} dh_cohort_local;
+
+typedef struct {
+    dh_futex_mutex global;     // Pode ser solto por outra thread da coorte
+    int num_nodes;
+    int num_cpus;
+    int* cpu_node;             // CPU -> nó
+    dh_cohort_local* locals;
+    dh_cohort_local* holder;
+} dh_cohort_lock;
+
+typedef struct {
+    dh_lock_kind kind;
+    union {
+        dh_futex_mutex futex;
+        dh_mcs_lock mcs;
+        dh_clh_lock clh;
+        dh_cohort_lock cohort;
+    } u;
+} dh_lock;
+
+/* Retorna 0 em sucesso, -1 se faltar memória */
+int dh_lock_init(dh_lock* lock, dh_lock_kind kind);
+void dh_lock_destroy(dh_lock* lock);
+
+void dh_lock_acquire(dh_lock* lock);
+void dh_lock_release(dh_lock* lock);
+
+/* Variável de condição por sequência (mesma ideia de dh_futex_cond) */
+typedef struct {
+    atomic_int seq;
+} dh_lock_cond;
+
+static inline void dh_lock_cond_wait(dh_lock_cond* c, dh_lock* lock) {
+    int seq = atomic_load(&c->seq);
+    dh_lock_release(lock);
+    dh_futex_wait(&c->seq, seq, NULL);
+    dh_lock_acquire(lock);
+}
+
+static inline void dh_lock_cond_signal(dh_lock_cond* c) {
+    atomic_fetch_add(&c->seq, 1);
+    dh_futex_wake(&c->seq, 1);
+}
+
+static inline void dh_lock_cond_broadcast(dh_lock_cond* c) {
+    atomic_fetch_add(&c->seq, 1);
+    dh_futex_wake(&c->seq, INT_MAX);
+}
+
+#endif /* DH_LOCK_H */
@@ -0,0 +1,119 @@
+/*
+ * dh_perf.c
+ * Grupo de contadores perf_event_open por thread (ver dh_perf.h).
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "dh_perf.h"
+
+static const struct {
+    uint32_t type;
+    uint64_t config;
+    const char* name;
+} COUNTERS[DH_PERF_NUM_COUNTERS] = {
+    [DH_PERF_CYCLES]       = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "ciclos" },
+    [DH_PERF_INSTRUCTIONS] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instrucoes" },
+    [DH_PERF_CACHE_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "cache-misses" },
+    [DH_PERF_CTX_SWITCHES] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, "trocas-ctx" },
+    [DH_PERF_TASK_CLOCK]   = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, "cpu(ns)" },
+};
+
+/* Formato de leitura do grupo */
+#define READ_FORMAT (PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | \
+                     PERF_FORMAT_TOTAL_TIME_RUNNING)
+
+static int open_counter(int counter, int group_fd, bool user_only) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = COUNTERS[counter].type;
+    attr.config = COUNTERS[counter].config;
+    attr.read_format = READ_FORMAT;
+    attr.exclude_kernel = user_only;
+    attr.exclude_hv = 1;
+    attr.disabled = (group_fd == -1);  // O líder liga o grupo inteiro no fim
+
+    // pid = 0, cpu = -1: esta thread, em qualquer CPU
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+int dh_perf_open(dh_perf_group* g, int* err) {
+    int first_errno = 0;
+    g->nr = 0;
+    g->user_only = false;
+    for (int c = 0; c < DH_PERF_NUM_COUNTERS; c++) {
+        g->fds[c] = -1;
+        g->slot[c] = -1;
+    }
+
+    int leader = -1;
+    for (int c = 0; c < DH_PERF_NUM_COUNTERS; c++) {
+        int fd = open_counter(c, leader, g->user_only);
+        if (fd < 0 && (errno == EACCES || errno == EPERM) && !g->user_only && g->nr == 0) {
+            // perf_event_paranoid não deixa contar no kernel: tenta só usuário
+            g->user_only = true;
+            fd = open_counter(c, leader, true);
+        }
+        if (fd < 0) {
+            if (first_errno == 0) first_errno = errno;
+            continue; // Ex.: ENOENT = evento inexistente nesta máquina
+        }
+
+        if (leader == -1) leader = fd;
+        g->fds[c] = fd;
+        g->slot[c] = g->nr++;
+    }
+
+    if (leader == -1) {
+        if (err) *err = first_errno;
+        return 0;
+    }
+
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return g->nr;
+}
+
+bool dh_perf_read(const dh_perf_group* g, dh_perf_sample* out) {
+    memset(out, 0, sizeof(*out));
+    if (g->nr == 0) return false;
+
+    int leader = -1;
+    for (int c = 0; c < DH_PERF_NUM_COUNTERS && leader == -1; c++) {
+        if (g->slot[c] == 0) leader = g->fds[c];
+    }
+
+    // nr, time_enabled, time_running, values[nr]
+    uint64_t buf[3 + DH_PERF_NUM_COUNTERS];
+    ssize_t want = (ssize_t)sizeof(uint64_t) * (3 + g->nr);
+    if (read(leader, buf, want) != want) return false;
+
+    // Grupo multiplexado (mais eventos que contadores físicos): extrapola
+    double scale = 1.0;
+    if (buf[2] > 0 && buf[2] < buf[1]) scale = (double)buf[1] / (double)buf[2];
+
+    for (int c = 0; c < DH_PERF_NUM_COUNTERS; c++) {
+        if (g->slot[c] >= 0) out->v[c] = (uint64_t)(buf[3 + g->slot[c]] * scale);
+    }
+    return true;
+}
+
+void dh_perf_close(dh_perf_group* g) {
+    for (int c = 0; c < DH_PERF_NUM_COUNTERS; c++) {
+        if (g->fds[c] >= 0) close(g->fds[c]);
+        g->fds[c] = -1;
+        g->slot[c] = -1;
+    }
+    g->nr = 0;
+}
+
+const char* dh_perf_counter_name(int counter) {
+    return COUNTERS[counter].name;
+}
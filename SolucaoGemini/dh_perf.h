@@ -0,0 +1,66 @@
+/*
+ * dh_perf.h
+ * Contadores de hardware/software por thread via perf_event_open, para
+ * medir cada fase da simulação sem um profiler externo (dining_hall -p).
+ *
+ * Todos os contadores da thread ficam num grupo só: uma leitura (um
+ * read()) devolve todos de uma vez, medidos no mesmo intervalo. Contador
+ * que o kernel/VM não oferece (ex.: ciclos numa VM sem PMU) fica de fora
+ * e aparece como indisponível. Se o kernel não permitir contar em modo
+ * kernel (perf_event_paranoid >= 2), conta só em modo usuário.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#ifndef DH_PERF_H
+#define DH_PERF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    DH_PERF_CYCLES,
+    DH_PERF_INSTRUCTIONS,
+    DH_PERF_CACHE_MISSES,
+    DH_PERF_CTX_SWITCHES,
+    DH_PERF_TASK_CLOCK,        // Tempo de CPU da thread (ns)
+    DH_PERF_NUM_COUNTERS
+};
+
+typedef struct {
+    int fds[DH_PERF_NUM_COUNTERS];    // -1 = indisponível
+    int slot[DH_PERF_NUM_COUNTERS];   // Posição no grupo lido (ou -1)
+    int nr;                           // Contadores no grupo
+    bool user_only;                   // Sem permissão para contar no kernel
+} dh_perf_group;
+
+typedef struct {
+    uint64_t v[DH_PERF_NUM_COUNTERS];
+} dh_perf_sample;
+
+/*
+ * Abre o grupo para a thread atual (qualquer CPU). Retorna quantos
+ * contadores abriram; 0 = nenhum, com o errno do primeiro em *err.
+ */
+int dh_perf_open(dh_perf_group* g, int* err);
+
+/* Lê todos os contadores (escalados se o kernel multiplexou o grupo) */
+bool dh_perf_read(const dh_perf_group* g, dh_perf_sample* out);
+
+void dh_perf_close(dh_perf_group* g);
+
+/* O contador abriu? */
+static inline bool dh_perf_has(const dh_perf_group* g, int counter) {
+    return g->slot[counter] >= 0;
+}
+
+const char* dh_perf_counter_name(int counter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DH_PERF_H */
@@ -0,0 +1,208 @@
+/*
+ * dh_place.c
+ * Topologia de /sys/devices/system/cpu e políticas de posicionamento
+ * (ver dh_place.h).
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#define _GNU_SOURCE            // CPU_SET, pthread_setaffinity_np
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "dh_place.h"
+
+static const char* POLICY_NAMES[DH_PLACE_NUM_POLICIES] = {
+    "none", "compact", "scatter", "group", "pairs"
+};
+
+/* Entrada a ordenar por uma chave composta (campos de 20 bits) */
+typedef struct {
+    long long key;
+    int index;
+} Keyed;
+
+static long long key3(int a, int b, int c) {
+    return ((long long)a << 40) | ((long long)b << 20) | (long long)c;
+}
+
+static int cmp_keyed(const void* a, const void* b) {
+    const Keyed* x = a;
+    const Keyed* y = b;
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+/* Lê um inteiro de /sys/devices/system/cpu/cpuN/topology/<name>; -1 se não der */
+static int read_topology(int cpu, const char* name) {
+    char path[96];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+    FILE* f = fopen(path, "r");
+    if (f == NULL) return -1;
+    int value;
+    if (fscanf(f, "%d", &value) != 1) value = -1;
+    fclose(f);
+    return value;
+}
+
+int dh_topology_load(dh_topology_t* topo) {
+    memset(topo, 0, sizeof(*topo));
+
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return -1;
+    int n = CPU_COUNT(&allowed);
+    if (n < 1) {
+        errno = ENODEV;
+        return -1;
+    }
+
+    Keyed* order = malloc(sizeof(Keyed) * n);
+    int* raw_pkg = malloc(sizeof(int) * CPU_SETSIZE);
+    int* raw_core = malloc(sizeof(int) * CPU_SETSIZE);
+    int* core_rank = malloc(sizeof(int) * n);   // Núcleo dentro do pacote
+    int* first_core = malloc(sizeof(int) * n);  // Por pacote: primeiro núcleo
+    topo->cpu = malloc(sizeof(int) * n);
+    topo->core = malloc(sizeof(int) * n);
+    topo->package = malloc(sizeof(int) * n);
+    topo->core_start = malloc(sizeof(int) * n);
+    topo->core_len = calloc(n, sizeof(int));
+    topo->scatter = malloc(sizeof(int) * n);
+    topo->core_scatter = malloc(sizeof(int) * n);
+    int rc = 0;
+    if (!order || !raw_pkg || !raw_core || !core_rank || !first_core || !topo->cpu ||
+        !topo->core || !topo->package || !topo->core_start || !topo->core_len ||
+        !topo->scatter || !topo->core_scatter) {
+        dh_topology_free(topo);
+        errno = ENOMEM;
+        rc = -1;
+        goto out;
+    }
+
+    // Sem o arquivo (container, kernel antigo): cada CPU é um núcleo do pacote 0
+    int k = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE && k < n; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        int pkg = read_topology(cpu, "physical_package_id");
+        int core = read_topology(cpu, "core_id");
+        raw_pkg[cpu] = pkg < 0 ? 0 : pkg;
+        raw_core[cpu] = core < 0 ? cpu : core;
+        order[k].key = key3(raw_pkg[cpu], raw_core[cpu], cpu);
+        order[k].index = cpu;
+        k++;
+    }
+    qsort(order, n, sizeof(Keyed), cmp_keyed);
+
+    // Ordem compacta; núcleos e pacotes renumerados na ordem em que aparecem
+    topo->num_cpus = n;
+    for (int i = 0; i < n; i++) {
+        int cpu = order[i].index;
+        topo->cpu[i] = cpu;
+        bool new_pkg = i == 0 || raw_pkg[cpu] != raw_pkg[topo->cpu[i - 1]];
+        bool new_core = new_pkg || raw_core[cpu] != raw_core[topo->cpu[i - 1]];
+        if (new_pkg) first_core[topo->num_packages++] = topo->num_cores;
+        if (new_core) topo->core_start[topo->num_cores++] = i;
+        topo->package[i] = topo->num_packages - 1;
+        topo->core[i] = topo->num_cores - 1;
+        topo->core_len[topo->core[i]]++;
+    }
+    for (int c = 0, p = 0; c < topo->num_cores; c++) {
+        while (p + 1 < topo->num_packages && first_core[p + 1] <= c) p++;
+        core_rank[c] = c - first_core[p];
+    }
+
+    // Scatter: varia primeiro o pacote, depois o núcleo, por último a irmã SMT
+    for (int i = 0; i < n; i++) {
+        int c = topo->core[i];
+        order[i].key = key3(i - topo->core_start[c], core_rank[c], topo->package[i]);
+        order[i].index = i;
+    }
+    qsort(order, n, sizeof(Keyed), cmp_keyed);
+    for (int i = 0; i < n; i++) topo->scatter[i] = order[i].index;
+
+    for (int c = 0; c < topo->num_cores; c++) {
+        order[c].key = key3(0, core_rank[c], topo->package[topo->core_start[c]]);
+        order[c].index = c;
+    }
+    qsort(order, topo->num_cores, sizeof(Keyed), cmp_keyed);
+    for (int c = 0; c < topo->num_cores; c++) topo->core_scatter[c] = order[c].index;
+
+out:
+    free(core_rank);
+    free(first_core);
+    free(raw_core);
+    free(raw_pkg);
+    free(order);
+    return rc;
+}
+
+void dh_topology_free(dh_topology_t* topo) {
+    free(topo->cpu);
+    free(topo->core);
+    free(topo->package);
+    free(topo->core_start);
+    free(topo->core_len);
+    free(topo->scatter);
+    free(topo->core_scatter);
+    memset(topo, 0, sizeof(*topo));
+}
+
+int dh_place_parse(const char* name) {
+    for (int p = 0; p < DH_PLACE_NUM_POLICIES; p++) {
+        if (strcmp(POLICY_NAMES[p], name) == 0) return p;
+    }
+    return -1;
+}
+
+const char* dh_place_name(int policy) {
+    return policy >= 0 && policy < DH_PLACE_NUM_POLICIES ? POLICY_NAMES[policy] : "?";
+}
+
+int dh_place_cpu(const dh_topology_t* topo, dh_place_policy_t policy, int index, int num_halls) {
+    if (topo->num_cpus == 0) return -1;
+    int n = topo->num_cpus;
+
+    switch (policy) {
+    case DH_PLACE_COMPACT:
+        return topo->cpu[index % n];
+
+    case DH_PLACE_SCATTER:
+        return topo->cpu[topo->scatter[index % n]];
+
+    case DH_PLACE_GROUP: {
+        // Refeitório h fica com os núcleos [h*C/H, (h+1)*C/H); sobra núcleo
+        // de menos que refeitório, divide o núcleo h % C
+        if (num_halls < 1) num_halls = 1;
+        int hall = index % num_halls, pos = index / num_halls;
+        int cores = topo->num_cores;
+        int first = cores >= num_halls ? hall * cores / num_halls : hall % cores;
+        int last = cores >= num_halls ? (hall + 1) * cores / num_halls : first + 1;
+        int start = topo->core_start[first];
+        int end = last < cores ? topo->core_start[last] : n;
+        return topo->cpu[start + pos % (end - start)];
+    }
+
+    case DH_PLACE_PAIRS: {
+        int core = topo->core_scatter[(index / 2) % topo->num_cores];
+        return topo->cpu[topo->core_start[core] + (index % 2) % topo->core_len[core]];
+    }
+
+    default:
+        return -1;
+    }
+}
+
+int dh_place_self(int cpu) {
+    if (cpu < 0) return 0;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
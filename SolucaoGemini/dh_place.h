@@ -0,0 +1,77 @@
+/*
+ * dh_place.h
+ * Posicionamento das threads dos estudantes nas CPUs (dining_hall -a,
+ * bench_dininghall -a). A topologia vem de /sys/devices/system/cpu
+ * (cpuN/topology/physical_package_id e core_id), restrita às CPUs que o
+ * processo pode usar (sched_getaffinity).
+ *
+ *   none     não fixa (o escalonador decide)
+ *   compact  enche um núcleo (threads SMT irmãs), depois o próximo núcleo
+ *            do mesmo pacote, depois o próximo pacote
+ *   scatter  espalha: um por pacote, depois um por núcleo, e só então as
+ *            irmãs SMT
+ *   group    cada refeitório (estudante i -> refeitório i % H) ganha um
+ *            bloco contíguo de núcleos e fica compacto dentro dele
+ *   pairs    estudantes 2k e 2k+1 nas duas irmãs SMT de um mesmo núcleo
+ *            (ou no mesmo núcleo, sem SMT); os pares se espalham pelos
+ *            núcleos como no scatter
+ *
+ * O monitor forma pares com quem estiver esperando, então "pairs" não
+ * garante que 2k e 2k+1 comam juntos; garante que, quando comem, a
+ * barreira de leave_hall acorda uma thread no mesmo núcleo.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#ifndef DH_PLACE_H
+#define DH_PLACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    DH_PLACE_NONE,
+    DH_PLACE_COMPACT,
+    DH_PLACE_SCATTER,
+    DH_PLACE_GROUP,
+    DH_PLACE_PAIRS,
+    DH_PLACE_NUM_POLICIES
+} dh_place_policy_t;
+
+/* CPUs utilizáveis, em ordem compacta (pacote, núcleo, CPU) */
+typedef struct {
+    int num_cpus;
+    int* cpu;                  // Número da CPU no sistema
+    int* core;                 // Índice global do núcleo físico (0..num_cores-1)
+    int* package;              // Índice do pacote (0..num_packages-1)
+    int num_cores;
+    int num_packages;
+
+    int* core_start;           // Por núcleo: primeira entrada em cpu[]
+    int* core_len;             // Por núcleo: quantas CPUs (threads SMT)
+    int* scatter;              // Entradas de cpu[] na ordem do scatter
+    int* core_scatter;         // Núcleos na ordem do scatter (para pairs)
+} dh_topology_t;
+
+/* Lê a topologia. Retorna 0, ou -1 com errno. */
+int dh_topology_load(dh_topology_t* topo);
+void dh_topology_free(dh_topology_t* topo);
+
+/* "compact" -> DH_PLACE_COMPACT etc.; -1 se não conhece */
+int dh_place_parse(const char* name);
+const char* dh_place_name(int policy);
+
+/*
+ * CPU do estudante de índice `index` (0..n-1) com `num_halls` refeitórios,
+ * ou -1 para não fixar (DH_PLACE_NONE).
+ */
+int dh_place_cpu(const dh_topology_t* topo, dh_place_policy_t policy, int index, int num_halls);
+
+/* Fixa a thread que chama na CPU (pthread_setaffinity_np); -1 não faz nada */
+int dh_place_self(int cpu);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DH_PLACE_H */
@@ -0,0 +1,96 @@
+/*
+ * dh_probes.h
+ * Pontos de rastreio estáticos (USDT) nas decisões do monitor, para
+ * acompanhar execuções de produção com bpftrace/perf sem precisar da
+ * versão instrumentada (dining_hall_logged):
+ *
+ *   bpftrace -e 'usdt:./libdininghall.so:dininghall:enter_wait
+ *                { printf("%d esperando, eat=%d\n", arg0, arg1); }'
+ *
+ * Provedor "dininghall"; todos os pontos recebem os mesmos argumentos:
+ *   arg0 = id, arg1 = eating_count, arg2 = waiting_to_eat,
+ *   arg3 = waiting_to_leave, arg4 = finished_students
+ * Pontos: enter_request, enter_wait, enter_admitted, enter_abort,
+ *         leave_request, leave_wait, leave_left, done, invariant
+ *         (violação vista por dh_check; id = -1).
+ *
+ * Cada ponto vira UM nop no código, mais uma nota em .note.stapsdt com o
+ * endereço do nop e onde achar os argumentos (readelf -n mostra as notas).
+ * Com <sys/sdt.h> (systemtap-sdt-dev) usamos o cabeçalho oficial; sem ele,
+ * em x86-64, geramos a mesma nota aqui. Em outras arquiteturas sem
+ * sys/sdt.h, ou com -DDH_NO_PROBES, os pontos somem.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#ifndef DH_PROBES_H
+#define DH_PROBES_H
+
+#if defined(DH_NO_PROBES)
+#define DH_PROBES_IMPL 0
+#elif defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define DH_PROBES_IMPL 1
+#endif
+#endif
+
+#if !defined(DH_PROBES_IMPL) && defined(__x86_64__)
+#define DH_PROBES_IMPL 2
+#endif
+
+#ifndef DH_PROBES_IMPL
+#define DH_PROBES_IMPL 0
+#endif
+
+#if DH_PROBES_IMPL == 1
+
+#define DH_PROBE5(name, a0, a1, a2, a3, a4) \
+    DTRACE_PROBE5(dininghall, name, a0, a1, a2, a3, a4)
+
+#elif DH_PROBES_IMPL == 2
+
+/*
+ * Mesmo formato de nota do sys/sdt.h (versão 3): pc do nop, base para
+ * corrigir o pc em bibliotecas relocadas, semáforo (0 = nenhum), provedor,
+ * nome e os argumentos ("-4@%edi": int com sinal de 4 bytes em %edi).
+ * Todos os argumentos aqui são int.
+ */
+#define DH_PROBE5(name, a0, a1, a2, a3, a4)                                      \
+    __asm__ __volatile__(                                                        \
+        "990: nop\n"                                                             \
+        ".pushsection .note.stapsdt,\"?\",\"note\"\n"                            \
+        ".balign 4\n"                                                            \
+        ".4byte 992f-991f, 994f-993f, 3\n"                                       \
+        "991: .asciz \"stapsdt\"\n"                                              \
+        "992: .balign 4\n"                                                       \
+        "993: .8byte 990b\n"                                                     \
+        ".8byte _.stapsdt.base\n"                                                \
+        ".8byte 0\n"                                                             \
+        ".asciz \"dininghall\"\n"                                                \
+        ".asciz \"" #name "\"\n"                                                 \
+        ".asciz \"-4@%0 -4@%1 -4@%2 -4@%3 -4@%4\"\n"                             \
+        "994: .balign 4\n"                                                       \
+        ".popsection\n"                                                          \
+        ".ifndef _.stapsdt.base\n"                                               \
+        ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"  \
+        ".weak _.stapsdt.base\n"                                                 \
+        ".hidden _.stapsdt.base\n"                                               \
+        "_.stapsdt.base: .space 1\n"                                             \
+        ".size _.stapsdt.base, 1\n"                                              \
+        ".popsection\n"                                                          \
+        ".endif\n"                                                               \
+        :: "nor"((int)(a0)), "nor"((int)(a1)), "nor"((int)(a2)),                 \
+           "nor"((int)(a3)), "nor"((int)(a4)))
+
+#else
+
+#define DH_PROBE5(name, a0, a1, a2, a3, a4) do { } while (0)
+
+#endif
+
+/* Ponto com o id e os contadores de um dh_state_t* */
+#define DH_PROBE(name, id, s)                                                    \
+    DH_PROBE5(name, (id), (s)->eating_count, (s)->waiting_to_eat,                \
+              (s)->waiting_to_leave, (s)->finished_students)
+
+#endif /* DH_PROBES_H */
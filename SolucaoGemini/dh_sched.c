@@ -0,0 +1,311 @@
+/*
+ * dh_sched.c
+ * Gravação e reprodução do escalonamento (ver dh_sched.h).
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "dh_sched.h"
+#include "dh_engine.h"
+
+/* Cabeçalho do arquivo (fica mapeado durante a gravação) */
+typedef struct {
+    char magic[8];             // DH_SCHED_MAGIC
+    uint32_t version;
+    int32_t num_students;
+    int32_t seats;             // Limite de lugares (muda o protocolo de entrada)
+    char engine[16];
+    uint64_t capacity;         // Eventos que cabem depois do cabeçalho
+    atomic_ullong count;       // Eventos reservados (pode passar da capacidade)
+    uint32_t complete;         // dh_sched_stop rodou (0 = processo morreu gravando)
+    uint32_t reserved;
+} SchedHeader;
+
+/*
+ * Evento. `kind` é escrito por último (release): um evento reservado mas
+ * não escrito quando o processo morreu fica com kind = 0 e é ignorado.
+ */
+typedef struct {
+    atomic_uint kind;          // DH_SCHED_LOCK/WAKE/RAND/FAST/PAIR
+    int32_t id;
+    uint32_t value;            // RAND: valor sorteado
+    uint32_t reserved;
+} SchedEvent;
+
+atomic_int dh_sched_mode = 0;
+
+/* --- Gravação --- */
+
+static struct {
+    int fd;
+    SchedHeader* hdr;
+    SchedEvent* events;
+    size_t map_size;
+} rec = { .fd = -1 };
+
+static void rec_append(int id, int kind, unsigned value) {
+    uint64_t i = atomic_fetch_add_explicit(&rec.hdr->count, 1, memory_order_relaxed);
+    if (i >= rec.hdr->capacity) return; // Cheio: dh_sched_stop avisa
+
+    SchedEvent* e = &rec.events[i];
+    e->id = id;
+    e->value = value;
+    atomic_store_explicit(&e->kind, (unsigned)kind, memory_order_release);
+}
+
+int dh_sched_record(const char* path, const char* engine, int num_students, int seats) {
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+
+    size_t size = sizeof(SchedHeader) + (size_t)DH_SCHED_CAPACITY * sizeof(SchedEvent);
+    if (ftruncate(fd, (off_t)size) != 0) goto fail;   // Esparso: só ocupa o que for escrito
+
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) goto fail;
+
+    rec.fd = fd;
+    rec.hdr = map;
+    rec.events = (SchedEvent*)(rec.hdr + 1);
+    rec.map_size = size;
+
+    memcpy(rec.hdr->magic, DH_SCHED_MAGIC, sizeof(rec.hdr->magic));
+    rec.hdr->version = DH_SCHED_VERSION;
+    rec.hdr->num_students = num_students;
+    rec.hdr->seats = seats;
+    snprintf(rec.hdr->engine, sizeof(rec.hdr->engine), "%s", engine ? engine : "");
+    rec.hdr->capacity = DH_SCHED_CAPACITY;
+    atomic_init(&rec.hdr->count, 0);
+    rec.hdr->complete = 0;
+
+    atomic_fetch_or(&dh_sched_mode, DH_SCHED_RECORDING);
+    return 0;
+
+fail:;
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return -1;
+}
+
+/* --- Reprodução --- */
+
+typedef struct {
+    int id;
+    int kind;
+} Turn;
+
+static struct {
+    Turn* turns;               // Eventos LOCK/WAKE/FAST/PAIR, na ordem gravada
+    int nturns;
+    atomic_int next;           // Próximo turno (também é a palavra de futex)
+
+    int max_id;
+    unsigned** rand_vals;      // Por id: sorteios na ordem gravada
+    int* rand_len;
+    int* rand_pos;             // Só a thread do próprio id mexe
+
+    dh_sched_info_t info;
+} rp;
+
+int dh_sched_replay(const char* path, dh_sched_info_t* info) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(SchedHeader)) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    SchedHeader* hdr = map;
+    if (memcmp(hdr->magic, DH_SCHED_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version != DH_SCHED_VERSION) {
+        munmap(map, (size_t)st.st_size);
+        errno = EINVAL;
+        return -1;
+    }
+
+    // Arquivo encolhido por dh_sched_stop ou inteiro (gravação morta no meio)
+    uint64_t count = atomic_load(&hdr->count);
+    uint64_t fits = ((uint64_t)st.st_size - sizeof(SchedHeader)) / sizeof(SchedEvent);
+    if (count > fits) count = fits;
+    const SchedEvent* events = (const SchedEvent*)(hdr + 1);
+
+    // Duas passadas: conta por tipo/id, depois preenche
+    int max_id = 0;
+    uint64_t nturns = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        unsigned kind = atomic_load_explicit(&events[i].kind, memory_order_relaxed);
+        if (kind == 0 || events[i].id < 0) continue;
+        if (events[i].id > max_id) max_id = events[i].id;
+        if (kind != DH_SCHED_RAND) nturns++;
+    }
+
+    memset(&rp, 0, sizeof(rp));
+    rp.turns = malloc(sizeof(Turn) * (nturns ? nturns : 1));
+    rp.max_id = max_id;
+    rp.rand_vals = calloc(max_id + 1, sizeof(unsigned*));
+    rp.rand_len = calloc(max_id + 1, sizeof(int));
+    rp.rand_pos = calloc(max_id + 1, sizeof(int));
+
+    for (uint64_t i = 0; i < count; i++) {
+        unsigned kind = atomic_load_explicit(&events[i].kind, memory_order_relaxed);
+        if (kind == DH_SCHED_RAND && events[i].id >= 0) rp.rand_len[events[i].id]++;
+    }
+    for (int id = 0; id <= max_id; id++) {
+        if (rp.rand_len[id] > 0) rp.rand_vals[id] = malloc(sizeof(unsigned) * rp.rand_len[id]);
+        rp.rand_len[id] = 0;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        unsigned kind = atomic_load_explicit(&events[i].kind, memory_order_relaxed);
+        int id = events[i].id;
+        if (kind == 0 || id < 0) continue;
+        if (kind == DH_SCHED_RAND) {
+            rp.rand_vals[id][rp.rand_len[id]++] = events[i].value;
+        } else {
+            rp.turns[rp.nturns].id = id;
+            rp.turns[rp.nturns].kind = (int)kind;
+            rp.nturns++;
+        }
+    }
+    atomic_init(&rp.next, 0);
+
+    rp.info.num_students = hdr->num_students;
+    rp.info.seats = hdr->seats;
+    memcpy(rp.info.engine, hdr->engine, sizeof(rp.info.engine));
+    rp.info.engine[sizeof(rp.info.engine) - 1] = '\0';
+    rp.info.events = count;
+    rp.info.turns = (uint64_t)rp.nturns;
+    rp.info.truncated = atomic_load(&hdr->count) > fits;
+    rp.info.complete = hdr->complete != 0;
+    munmap(map, (size_t)st.st_size);
+
+    if (info) *info = rp.info;
+    atomic_fetch_or(&dh_sched_mode, DH_SCHED_REPLAYING);
+    return 0;
+}
+
+bool dh_sched_replaying(void) {
+    return (atomic_load_explicit(&dh_sched_mode, memory_order_relaxed) & DH_SCHED_REPLAYING) &&
+           atomic_load_explicit(&rp.next, memory_order_acquire) < rp.nturns;
+}
+
+bool dh_sched_turn(int id, int kind) {
+    if (!(atomic_load_explicit(&dh_sched_mode, memory_order_relaxed) & DH_SCHED_REPLAYING)) {
+        return false;
+    }
+
+    int spins = 0;
+    while (true) {
+        int t = atomic_load_explicit(&rp.next, memory_order_acquire);
+        if (t >= rp.nturns) return false;  // Arquivo acabou: execução livre
+        if (rp.turns[t].id == id && rp.turns[t].kind == kind) return true;
+
+        if (spins < DH_SPIN_LIMIT) {
+            dh_spin_backoff(&spins);
+        } else {
+            dh_futex_wait(&rp.next, t, NULL);
+        }
+    }
+}
+
+/*
+ * Reproduzindo: espera o próximo turno do arquivo ser de `id` e diz se é
+ * do tipo `kind`, sem consumi-lo. Sem reprodução, ou com o arquivo
+ * acabado, retorna true (execução livre).
+ */
+bool dh_sched_next_is(int id, int kind) {
+    if (!(atomic_load_explicit(&dh_sched_mode, memory_order_relaxed) & DH_SCHED_REPLAYING)) {
+        return true;
+    }
+
+    int spins = 0;
+    while (true) {
+        int t = atomic_load_explicit(&rp.next, memory_order_acquire);
+        if (t >= rp.nturns) return true;
+        if (rp.turns[t].id == id) return rp.turns[t].kind == kind;
+
+        if (spins < DH_SPIN_LIMIT) {
+            dh_spin_backoff(&spins);
+        } else {
+            dh_futex_wait(&rp.next, t, NULL);
+        }
+    }
+}
+
+void dh_sched_pass(bool turn) {
+    if (!turn) return;
+    atomic_fetch_add_explicit(&rp.next, 1, memory_order_release);
+    dh_futex_wake(&rp.next, INT_MAX);
+}
+
+void dh_sched_taken(int id, int kind, bool turn) {
+    int mode = atomic_load_explicit(&dh_sched_mode, memory_order_relaxed);
+    if (mode & DH_SCHED_RECORDING) rec_append(id, kind, 0);
+    dh_sched_pass(turn);
+}
+
+unsigned dh_sched_rand(int id, unsigned value) {
+    int mode = atomic_load_explicit(&dh_sched_mode, memory_order_relaxed);
+    if ((mode & DH_SCHED_REPLAYING) && id >= 0 && id <= rp.max_id &&
+        rp.rand_pos[id] < rp.rand_len[id]) {
+        value = rp.rand_vals[id][rp.rand_pos[id]++];
+    }
+    if (mode & DH_SCHED_RECORDING) rec_append(id, DH_SCHED_RAND, value);
+    return value;
+}
+
+void dh_sched_stop(dh_sched_info_t* recorded, dh_sched_info_t* replayed) {
+    int mode = atomic_exchange(&dh_sched_mode, 0);
+
+    if (mode & DH_SCHED_RECORDING) {
+        uint64_t count = atomic_load(&rec.hdr->count);
+        bool truncated = count > rec.hdr->capacity;
+        if (truncated) count = rec.hdr->capacity;
+
+        if (recorded) {
+            memset(recorded, 0, sizeof(*recorded));
+            recorded->num_students = rec.hdr->num_students;
+            recorded->seats = rec.hdr->seats;
+            memcpy(recorded->engine, rec.hdr->engine, sizeof(recorded->engine));
+            recorded->events = count;
+            recorded->truncated = truncated;
+            recorded->complete = true;
+        }
+        rec.hdr->complete = 1;
+
+        // Encolhe o arquivo para o que foi gravado
+        munmap(rec.hdr, rec.map_size);
+        if (ftruncate(rec.fd, (off_t)(sizeof(SchedHeader) + count * sizeof(SchedEvent))) != 0) {
+            // Continua válido: o leitor usa o mínimo entre count e o tamanho
+        }
+        close(rec.fd);
+        rec.fd = -1;
+        rec.hdr = NULL;
+    }
+
+    if (mode & DH_SCHED_REPLAYING) {
+        rp.info.replayed = (uint64_t)atomic_load(&rp.next);
+        if (replayed) *replayed = rp.info;
+
+        for (int id = 0; id <= rp.max_id; id++) free(rp.rand_vals[id]);
+        free(rp.rand_vals);
+        free(rp.rand_len);
+        free(rp.rand_pos);
+        free(rp.turns);
+        memset(&rp, 0, sizeof(rp));
+    }
+}
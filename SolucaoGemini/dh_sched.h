@@ -0,0 +1,85 @@
+/*
+ * dh_sched.h
+ * Gravação e reprodução do escalonamento de uma execução, para que uma
+ * rodada que travou no stress_tester.py vire um artefato reprodutível
+ * (dining_hall -r grava, -R reproduz).
+ *
+ * Gravação: cada aquisição do lock do monitor (LOCK) e cada retorno de
+ * espera na condvar (WAKE) vira um evento, anexado com o lock na mão, então
+ * a ordem no arquivo é a ordem real. A saída rápida sem lock
+ * (dh_fast_leave) também grava o seu turno (FAST), logo depois do CAS, e
+ * o primeiro do par grava um PAIR ao voltar da barreira (dh_pair_wait). Os sorteios do driver (RAND) vão no
+ * mesmo arquivo, por estudante. O arquivo é mapeado com MAP_SHARED: o que
+ * foi gravado sobrevive mesmo a um SIGKILL (timeout do testador). Custo
+ * por evento: um fetch_add e um registro de 16 bytes na memória.
+ *
+ * Reprodução: cada thread só pega o lock quando o próximo evento do
+ * arquivo é dela, e espera na condvar vira "esperar a minha vez de WAKE"
+ * (e a volta da barreira, "esperar a minha vez de PAIR");
+ * a saída só tenta o CAS quando o próximo evento dela é FAST. Os sorteios
+ * devolvem os valores gravados. O que se reproduz é a ordem dos turnos:
+ * o CAS da saída rápida não é serializado com a seção crítica de quem
+ * tem o lock (o protocolo não depende disso), então dentro de uma seção
+ * crítica a intercalação pode diferir da gravada. Se o arquivo acabar
+ * (gravação cortada pelo kill), o resto da execução segue livre.
+ *
+ * Só o motor "mutex" tem os ganchos de lock e condvar; o protocolo é o
+ * mesmo de uma execução sem gravação.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#ifndef DH_SCHED_H
+#define DH_SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DH_SCHED_MAGIC    "DHSCHED1"
+#define DH_SCHED_VERSION  4       // 2: turnos FAST; 3: turnos PAIR; 4: lugares
+
+/* Eventos gravados por arquivo (o arquivo é esparso até o fim da gravação) */
+#define DH_SCHED_CAPACITY (1u << 20)
+
+typedef struct {
+    int num_students;
+    int seats;                 // Limite de lugares (dh_set_capacity; 0 = sem limite)
+    char engine[16];
+    uint64_t events;           // Eventos no arquivo
+    uint64_t turns;            // Reprodução: eventos de LOCK/WAKE/FAST/PAIR
+    uint64_t replayed;         // Reprodução: quantos deles já foram seguidos
+    bool truncated;            // Gravação passou de DH_SCHED_CAPACITY
+    bool complete;             // Gravação terminou (false = processo morreu gravando)
+} dh_sched_info_t;
+
+/*
+ * Começa a gravar em `path` (ligar antes de criar as threads). Retorna 0,
+ * ou -1 com errno.
+ */
+int dh_sched_record(const char* path, const char* engine, int num_students, int seats);
+
+/*
+ * Carrega `path` e liga a reprodução. Pode ser combinada com
+ * dh_sched_record (grava de novo enquanto reproduz). Retorna 0, ou -1 com
+ * errno (EINVAL = não é um arquivo de escalonamento).
+ */
+int dh_sched_replay(const char* path, dh_sched_info_t* info);
+
+/*
+ * Sorteio do estudante `id`: gravando, registra `value` e o devolve;
+ * reproduzindo, devolve o próximo valor gravado para `id` (ou `value`, se
+ * acabaram).
+ */
+unsigned dh_sched_rand(int id, unsigned value);
+
+/* Encerra (depois do join das threads); preenche o que não for NULL */
+void dh_sched_stop(dh_sched_info_t* recorded, dh_sched_info_t* replayed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DH_SCHED_H */
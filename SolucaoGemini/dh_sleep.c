@@ -0,0 +1,104 @@
+/*
+ * dh_sleep.c
+ * Sono com prazo absoluto, folga de timer e giro final (ver dh_sleep.h).
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/prctl.h>
+
+#include "dh_sleep.h"
+#include "dh_sync.h"
+
+static struct {
+    atomic_int mode;
+    atomic_long slack_ns;
+    atomic_long spin_ns;
+    atomic_uint generation;    // Muda a cada configure: threads reaplicam a folga
+} cfg;
+
+static __thread struct {
+    unsigned generation;
+    dh_sleep_stats_t stats;
+} sleep_thread;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static struct timespec to_timespec(uint64_t ns) {
+    struct timespec ts = { (time_t)(ns / 1000000000ull), (long)(ns % 1000000000ull) };
+    return ts;
+}
+
+void dh_sleep_configure(dh_sleep_mode_t mode, long slack_ns, long spin_ns) {
+    atomic_store(&cfg.mode, (int)mode);
+    atomic_store(&cfg.slack_ns, slack_ns);
+    atomic_store(&cfg.spin_ns, spin_ns < 0 ? 0 : spin_ns);
+    atomic_fetch_add_explicit(&cfg.generation, 1, memory_order_release);
+}
+
+static void sleep_relative(uint64_t ns) {
+    struct timespec req = to_timespec(ns), rem;
+    while (nanosleep(&req, &rem) != 0 && errno == EINTR) req = rem;
+}
+
+static void sleep_precise(uint64_t start, uint64_t ns) {
+    unsigned generation = atomic_load_explicit(&cfg.generation, memory_order_acquire);
+    if (sleep_thread.generation != generation) {
+        // 0 em PR_SET_TIMERSLACK volta ao padrão: só aplica valores positivos
+        long slack = atomic_load(&cfg.slack_ns);
+        if (slack > 0) prctl(PR_SET_TIMERSLACK, (unsigned long)slack, 0, 0, 0);
+        sleep_thread.generation = generation;
+    }
+
+    uint64_t deadline = start + ns;
+    uint64_t spin = (uint64_t)atomic_load_explicit(&cfg.spin_ns, memory_order_relaxed);
+    if (ns > spin) {
+        struct timespec wake = to_timespec(deadline - spin);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) == EINTR) {
+            // Prazo absoluto: repetir não acumula erro
+        }
+    }
+    while (now_ns() < deadline) dh_cpu_relax();
+}
+
+void dh_sleep_ns(uint64_t ns) {
+    uint64_t start = now_ns();
+    if (ns > 0) {
+        if (atomic_load_explicit(&cfg.mode, memory_order_relaxed) == DH_SLEEP_PRECISE) {
+            sleep_precise(start, ns);
+        } else {
+            sleep_relative(ns);
+        }
+    }
+    uint64_t actual = now_ns() - start;
+
+    dh_sleep_stats_t* st = &sleep_thread.stats;
+    uint64_t over = actual > ns ? actual - ns : 0;
+    st->count++;
+    st->planned_ns += ns;
+    st->actual_ns += actual;
+    if (over > st->max_over_ns) st->max_over_ns = over;
+
+    uint64_t us = over / 1000;
+    int b = 0;
+    while (us > 0 && b < DH_SLEEP_HIST_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    st->hist[b]++;
+}
+
+void dh_sleep_get(dh_sleep_stats_t* out) {
+    *out = sleep_thread.stats;
+}
+
+void dh_sleep_reset(void) {
+    memset(&sleep_thread.stats, 0, sizeof(sleep_thread.stats));
+}
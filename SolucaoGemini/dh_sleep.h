@@ -0,0 +1,66 @@
+/*
+ * dh_sleep.h
+ * Sono com prazo preciso para os tempos de get_food/dine (dining_hall -s).
+ * usleep(ms * 1000) dorme pelo menos o pedido e acorda quando o kernel
+ * quiser: soma a folga de timer da thread (50µs por padrão) e a latência
+ * do escalonador, o que distorce refeições curtas.
+ *
+ *   DH_SLEEP_RELATIVE  nanosleep relativo, folga padrão (= usleep)
+ *   DH_SLEEP_PRECISE   clock_nanosleep(TIMER_ABSTIME) até o prazo menos a
+ *                      janela de giro, com PR_SET_TIMERSLACK na thread, e
+ *                      giro (dh_cpu_relax) nos últimos microssegundos
+ *
+ * Com prazo absoluto, acordar por sinal e voltar a dormir não acumula
+ * erro. A folga é por thread: cada thread aplica a configuração atual no
+ * primeiro sono depois de dh_sleep_configure.
+ *
+ * Todo sono registra planejado x real na thread que dormiu; o atraso
+ * (real - planejado) vai para um histograma em potências de 2 de µs.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#ifndef DH_SLEEP_H
+#define DH_SLEEP_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    DH_SLEEP_RELATIVE,
+    DH_SLEEP_PRECISE
+} dh_sleep_mode_t;
+
+/* Balde 0 = atraso < 1µs, balde b = [2^(b-1), 2^b) µs; o último acumula o resto */
+#define DH_SLEEP_HIST_BUCKETS 20
+
+/* Totais de uma thread */
+typedef struct {
+    uint64_t count;
+    uint64_t planned_ns;
+    uint64_t actual_ns;
+    uint64_t max_over_ns;
+    uint64_t hist[DH_SLEEP_HIST_BUCKETS];
+} dh_sleep_stats_t;
+
+/*
+ * Troca o modo para todas as threads. `slack_ns` > 0 vira o
+ * PR_SET_TIMERSLACK de cada thread que dormir em DH_SLEEP_PRECISE (<= 0
+ * mantém o da thread); `spin_ns` é a janela final gasta girando.
+ */
+void dh_sleep_configure(dh_sleep_mode_t mode, long slack_ns, long spin_ns);
+
+/* Dorme `ns` nanossegundos no modo atual */
+void dh_sleep_ns(uint64_t ns);
+
+/* Totais da thread que chama */
+void dh_sleep_get(dh_sleep_stats_t* out);
+void dh_sleep_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DH_SLEEP_H */
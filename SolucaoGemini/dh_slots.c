@@ -0,0 +1,218 @@
+/*
+ * dh_slots.c
+ * Registros de publicação por thread (ver dh_slots.h).
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dh_slots.h"
+#include "dh_sync.h"
+
+/* Quantos refeitórios cada thread lembra sem consultar a lista */
+#define SLOT_CACHE_SIZE 4
+
+/* Voltas de espera ativa antes de dormir no futex */
+#define SLOT_SPIN_LIMIT 256
+
+/* Cache por thread: uid da lista -> slot desta thread nela */
+static __thread struct {
+    unsigned long uid;
+    dh_slot* slot;
+} slot_cache[SLOT_CACHE_SIZE];
+
+static __thread int slot_cache_next;
+
+static atomic_ulong next_list_uid = 1;
+
+void dh_slots_init(dh_slot_list* list) {
+    atomic_init(&list->head, NULL);
+    // uid único: um refeitório novo no mesmo endereço não herda o cache
+    list->uid = atomic_fetch_add(&next_list_uid, 1);
+}
+
+void dh_slots_free(dh_slot_list* list) {
+    dh_slot* slot = atomic_load(&list->head);
+    while (slot) {
+        dh_slot* next = slot->next;
+        free(slot);
+        slot = next;
+    }
+    atomic_store(&list->head, NULL);
+}
+
+/* Slot que esta thread já criou na lista, se houver (saiu do cache) */
+static dh_slot* slot_find(dh_slot_list* list, pthread_t self) {
+    for (dh_slot* slot = atomic_load(&list->head); slot; slot = slot->next) {
+        if (pthread_equal(slot->owner, self)) return slot;
+    }
+    return NULL;
+}
+
+dh_slot* dh_slot_for_thread(dh_slot_list* list) {
+    for (int i = 0; i < SLOT_CACHE_SIZE; i++) {
+        if (slot_cache[i].uid == list->uid) return slot_cache[i].slot;
+    }
+
+    // Fora do cache: procura na lista antes de criar, senão uma thread que
+    // alterna entre mais de SLOT_CACHE_SIZE refeitórios criaria um slot
+    // por troca. Só esta thread cria slots com o seu `owner`, então não há
+    // corrida entre achar e inserir. Slots só saem em dh_slots_free.
+    pthread_t self = pthread_self();
+    dh_slot* slot = slot_find(list, self);
+    if (slot == NULL) {
+        slot = aligned_alloc(DH_CACHE_LINE, sizeof(dh_slot));
+        if (slot == NULL) return NULL;
+        memset(slot, 0, sizeof(*slot));
+        atomic_init(&slot->status, DH_SLOT_IDLE);
+        slot->owner = self;
+
+        dh_slot* head = atomic_load(&list->head);
+        do {
+            slot->next = head;
+        } while (!atomic_compare_exchange_weak(&list->head, &head, slot));
+    }
+
+    slot_cache[slot_cache_next].uid = list->uid;
+    slot_cache[slot_cache_next].slot = slot;
+    slot_cache_next = (slot_cache_next + 1) % SLOT_CACHE_SIZE;
+    return slot;
+}
+
+void dh_slot_alloc_failed(const dh_hall_t* hall) {
+    // enter/leave/done não têm retorno de erro: sem slot não há como seguir
+    fprintf(stderr, "libdininghall: sem memória para o slot da thread (%s)\n", hall->ops->name);
+    abort();
+}
+
+void dh_slot_publish(dh_slot* slot, dh_op_t op, int id) {
+    slot->op = op;
+    slot->id = id;
+    slot->result = 0;
+    slot->stage = 0;
+    atomic_store_explicit(&slot->status, DH_SLOT_PENDING, memory_order_release);
+}
+
+/*
+ * Motivo de uma espera já concluída, para dh_waitstats: o aplicador deixou
+ * em `stage` se a entrada teve que esperar par (2) ou se a saída parou na
+ * barreira (1). Qualquer outra espera foi só pelo aplicador, o "lock".
+ */
+static dh_wait_reason_t slot_wait_reason(const dh_slot* slot) {
+    if (slot->op == DH_OP_ENTER && slot->stage == 2) return DH_WAIT_PAIR;
+    if (slot->op == DH_OP_LEAVE && slot->stage == 1) return DH_WAIT_BARRIER;
+    return DH_WAIT_LOCK;
+}
+
+int dh_slot_wait(dh_slot* slot) {
+    dh_wait_mark m;
+    bool timed = dh_wait_begin(&m);
+
+    for (int spins = 0; spins < SLOT_SPIN_LIMIT; spins++) {
+        if (atomic_load_explicit(&slot->status, memory_order_acquire) == DH_SLOT_DONE) {
+            goto done;
+        }
+        dh_cpu_relax();
+    }
+
+    // Avisa que vai dormir; se a resposta chegou nesse meio tempo, o CAS falha
+    int expected = DH_SLOT_PENDING;
+    if (atomic_compare_exchange_strong(&slot->status, &expected, DH_SLOT_SLEEPING)) {
+        while (atomic_load_explicit(&slot->status, memory_order_acquire) != DH_SLOT_DONE) {
+            dh_futex_wait(&slot->status, DH_SLOT_SLEEPING, NULL);
+        }
+    }
+
+done:
+    if (timed) dh_wait_end(&m, slot_wait_reason(slot));
+    atomic_store_explicit(&slot->status, DH_SLOT_IDLE, memory_order_relaxed);
+    return slot->result;
+}
+
+void dh_slot_complete(dh_slot* slot, int result) {
+    slot->result = result;
+    int old = atomic_exchange_explicit(&slot->status, DH_SLOT_DONE, memory_order_acq_rel);
+    if (old == DH_SLOT_SLEEPING) dh_futex_wake(&slot->status, 1);
+}
+
+bool dh_slot_apply(dh_state_t* s, dh_slot* slot) {
+    switch (slot->op) {
+    case DH_OP_ENTER:
+        if (slot->stage == 0) {
+            s->waiting_to_eat++;
+            slot->stage = 1;
+            DH_PROBE(enter_request, slot->id, s);
+        }
+        if (dh_can_sit(s)) {
+            s->waiting_to_eat--;
+            s->eating_count++;
+            DH_PROBE(enter_admitted, slot->id, s);
+            dh_slot_complete(slot, 1);
+            return true;
+        }
+        if (dh_must_abort(s)) {
+            s->waiting_to_eat--;
+            DH_PROBE(enter_abort, slot->id, s);
+            dh_slot_complete(slot, 0);
+            return true;
+        }
+        if (slot->stage == 1) {
+            DH_PROBE(enter_wait, slot->id, s);
+            slot->stage = 2; // Só avisa a espera uma vez
+        }
+        return false;
+
+    case DH_OP_LEAVE:
+        if (slot->stage == 0) {
+            DH_PROBE(leave_request, slot->id, s);
+            if (s->eating_count != 2) {
+                s->eating_count--;
+                DH_PROBE(leave_left, slot->id, s);
+                dh_slot_complete(slot, 0);
+                return true;
+            }
+            // Barreira: com 2 comendo, só sai junto com o par
+            s->waiting_to_leave++;
+            slot->stage = 1;
+            DH_PROBE(leave_wait, slot->id, s);
+        }
+        if (dh_leave_released(s)) {
+            s->waiting_to_leave--;
+            s->eating_count--;
+            DH_PROBE(leave_left, slot->id, s);
+            dh_slot_complete(slot, 0);
+            return true;
+        }
+        return false;
+
+    case DH_OP_DONE:
+        s->finished_students++;
+        DH_PROBE(done, slot->id, s);
+        dh_slot_complete(slot, 0);
+        return true;
+    }
+    return false;
+}
+
+int dh_slots_combine(dh_state_t* s, dh_slot_list* list) {
+    int completed = 0;
+    bool progress = true;
+
+    while (progress) {
+        progress = false;
+        for (dh_slot* slot = atomic_load(&list->head); slot; slot = slot->next) {
+            int status = atomic_load_explicit(&slot->status, memory_order_acquire);
+            if (status != DH_SLOT_PENDING && status != DH_SLOT_SLEEPING) continue;
+
+            // Uma chegada contada que não conclui não libera mais ninguém
+            // (se liberasse, liberaria ela mesma); só conclusões pedem outra volta.
+            if (dh_slot_apply(s, slot)) {
+                completed++;
+                progress = true;
+            }
+        }
+    }
+    return completed;
+}
@@ -0,0 +1,88 @@
+/*
+ * dh_slots.h
+ * Registros de publicação por thread, usados pelos motores em que UMA
+ * thread aplica os pedidos de todas as outras (flat combining e
+ * delegação). Cada thread publica enter/leave/done no seu próprio slot
+ * (uma linha de cache) e espera a resposta ali; o aplicador varre os
+ * slots e aplica os pedidos com as mesmas regras de dh_engine.h.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#ifndef DH_SLOTS_H
+#define DH_SLOTS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "dh_engine.h"
+
+#define DH_CACHE_LINE 64
+
+/* Pedido publicado num slot */
+typedef enum {
+    DH_OP_ENTER = 1,
+    DH_OP_LEAVE,
+    DH_OP_DONE
+} dh_op_t;
+
+/* Estados do slot (também é a palavra de futex do dono) */
+enum {
+    DH_SLOT_IDLE = 0,          // Sem pedido
+    DH_SLOT_PENDING,           // Pedido publicado, aguardando o aplicador
+    DH_SLOT_SLEEPING,          // Idem, e o dono está dormindo no futex
+    DH_SLOT_DONE               // Resposta pronta em `result`
+};
+
+typedef struct dh_slot {
+    _Alignas(DH_CACHE_LINE) atomic_int status;
+    int op;                    // dh_op_t
+    int id;
+    int result;                // ENTER: 1 = sentou, 0 = abortou
+    pthread_t owner;           // Thread dona (fixo desde a criação)
+
+    /* Só o aplicador mexe daqui para baixo */
+    int stage;                 // 0 = chegada ainda não contada; 2 = enter_wait já emitido
+    struct dh_slot* next;      // Lista de todos os slots do refeitório
+} dh_slot;
+
+/* Lista (só cresce) dos slots de um refeitório */
+typedef struct {
+    _Atomic(dh_slot*) head;
+    unsigned long uid;         // Identifica a lista no cache por thread
+} dh_slot_list;
+
+void dh_slots_init(dh_slot_list* list);
+void dh_slots_free(dh_slot_list* list);
+
+/*
+ * Slot da thread atual nesta lista (criado na primeira chamada; depois
+ * reaproveitado, mesmo que tenha saído do cache). NULL se faltou memória.
+ */
+dh_slot* dh_slot_for_thread(dh_slot_list* list);
+
+/* Motor: dh_slot_for_thread falhou; avisa em stderr e aborta */
+void dh_slot_alloc_failed(const dh_hall_t* hall) __attribute__((cold, noreturn));
+
+/* Dono: publica o pedido (status = PENDING, com release) */
+void dh_slot_publish(dh_slot* slot, dh_op_t op, int id);
+
+/* Dono: espera a resposta (gira um pouco e depois dorme), deixa o slot IDLE */
+int dh_slot_wait(dh_slot* slot);
+
+/* Aplicador: conclui o slot e acorda o dono se ele estiver dormindo */
+void dh_slot_complete(dh_slot* slot, int result);
+
+/*
+ * Aplicador: tenta aplicar um pedido pendente ao estado.
+ * Retorna true se concluiu (e já chamou dh_slot_complete).
+ */
+bool dh_slot_apply(dh_state_t* state, dh_slot* slot);
+
+/*
+ * Aplicador: varre a lista repetidamente até nenhum pedido pendente
+ * avançar. Retorna quantos pedidos foram concluídos.
+ */
+int dh_slots_combine(dh_state_t* state, dh_slot_list* list);
+
+#endif /* DH_SLOTS_H */
@@ -0,0 +1,123 @@
+/*
+ * dh_sync.h
+ * Primitivas de sincronização de baixo nível usadas pelos motores da
+ * libdininghall: wrappers de futex (Linux), um mutex e uma variável de
+ * condição feitos só com atômicos + futex, e um spinlock TTAS.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#ifndef DH_SYNC_H
+#define DH_SYNC_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+/* Quantas voltas de espera ativa antes de ceder a CPU (sched_yield) */
+#define DH_SPIN_LIMIT 128
+
+/* Dica para o processador durante espera ativa */
+static inline void dh_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+/* Espera ativa com recuo: gira um pouco e depois cede a CPU */
+static inline void dh_spin_backoff(int* spins) {
+    if (++*spins < DH_SPIN_LIMIT) dh_cpu_relax();
+    else sched_yield();
+}
+
+/* --- Futex --- */
+
+/* Dorme enquanto *addr == expected (ou até o timeout relativo, se houver) */
+static inline long dh_futex_wait(atomic_int* addr, int expected, const struct timespec* timeout) {
+    return syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, timeout, NULL, 0);
+}
+
+/* Acorda até n threads dormindo em addr */
+static inline long dh_futex_wake(atomic_int* addr, int n) {
+    return syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+
+/*
+ * Mutex de futex ("Futexes Are Tricky", Drepper, mutex 3).
+ * state: 0 = livre, 1 = travado, 2 = travado com possíveis esperas.
+ */
+typedef struct {
+    atomic_int state;
+} dh_futex_mutex;
+
+static inline void dh_futex_mutex_lock(dh_futex_mutex* m) {
+    int c = 0;
+    if (atomic_compare_exchange_strong(&m->state, &c, 1)) return;
+
+    if (c != 2) c = atomic_exchange(&m->state, 2);
+    while (c != 0) {
+        dh_futex_wait(&m->state, 2, NULL);
+        c = atomic_exchange(&m->state, 2);
+    }
+}
+
+static inline void dh_futex_mutex_unlock(dh_futex_mutex* m) {
+    if (atomic_fetch_sub(&m->state, 1) != 1) {
+        atomic_store(&m->state, 0);
+        dh_futex_wake(&m->state, 1);
+    }
+}
+
+/*
+ * Variável de condição de futex: um contador de sequência. Quem espera
+ * lê a sequência antes de soltar o mutex; qualquer signal/broadcast
+ * posterior muda o valor e o futex_wait não dorme (sem wakeup perdido).
+ */
+typedef struct {
+    atomic_int seq;
+} dh_futex_cond;
+
+static inline void dh_futex_cond_wait(dh_futex_cond* c, dh_futex_mutex* m) {
+    int seq = atomic_load(&c->seq);
+    dh_futex_mutex_unlock(m);
+    dh_futex_wait(&c->seq, seq, NULL);
+    dh_futex_mutex_lock(m);
+}
+
+static inline void dh_futex_cond_signal(dh_futex_cond* c) {
+    atomic_fetch_add(&c->seq, 1);
+    dh_futex_wake(&c->seq, 1);
+}
+
+static inline void dh_futex_cond_broadcast(dh_futex_cond* c) {
+    atomic_fetch_add(&c->seq, 1);
+    dh_futex_wake(&c->seq, INT_MAX);
+}
+
+/* --- Spinlock TTAS (test-and-test-and-set) --- */
+
+typedef struct {
+    atomic_int locked;
+} dh_spinlock;
+
+static inline void dh_spin_lock(dh_spinlock* l) {
+    int spins = 0;
+    while (true) {
+        if (!atomic_exchange_explicit(&l->locked, 1, memory_order_acquire)) return;
+        while (atomic_load_explicit(&l->locked, memory_order_relaxed)) {
+            dh_spin_backoff(&spins);
+        }
+    }
+}
+
+static inline void dh_spin_unlock(dh_spinlock* l) {
+    atomic_store_explicit(&l->locked, 0, memory_order_release);
+}
+
+#endif /* DH_SYNC_H */
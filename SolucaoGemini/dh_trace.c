@@ -0,0 +1,195 @@
+/*
+ * dh_trace.c
+ * Escrita e leitura do formato binário de rastro (ver dh_trace.h).
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "dh_trace.h"
+
+static uint64_t trace_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* write() até o fim (EINTR/escritas parciais) */
+static int write_all(int fd, const void* data, size_t len) {
+    const char* p = data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+int dh_trace_open(dh_trace_writer* w, const char* path, const dh_trace_header* header) {
+    // O_APPEND: cada flush de thread vai inteiro para o fim do arquivo
+    w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (w->fd < 0) return -1;
+
+    w->start_ns = trace_now_ns();
+    atomic_init(&w->records, 0);
+    atomic_init(&w->failed, 0);
+
+    dh_trace_header h = *header;
+    memcpy(h.magic, DH_TRACE_MAGIC, sizeof(h.magic));
+    h.version = DH_TRACE_VERSION;
+
+    struct timespec wall;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    h.start_realtime_ns = (uint64_t)wall.tv_sec * 1000000000ull + (uint64_t)wall.tv_nsec;
+
+    if (write_all(w->fd, &h, sizeof(h)) != 0) {
+        close(w->fd);
+        return -1;
+    }
+    return 0;
+}
+
+void dh_trace_flush(dh_trace_buffer* b) {
+    if (b->count == 0) return;
+    dh_trace_writer* w = b->writer;
+    if (write_all(w->fd, b->buf, sizeof(dh_trace_record) * b->count) != 0) {
+        atomic_store(&w->failed, 1);
+    } else {
+        atomic_fetch_add(&w->records, (unsigned long long)b->count);
+    }
+    b->count = 0;
+}
+
+void dh_trace_emit(dh_trace_buffer* b, int student, dh_trace_event event, const dh_hall_t* hall) {
+    dh_stats_t st;
+    dh_snapshot(hall, &st);
+
+    dh_trace_record* r = &b->buf[b->count];
+    r->t_ns = trace_now_ns() - b->writer->start_ns;
+    r->student = (uint32_t)student;
+    r->event = (uint16_t)event;
+    r->reserved = 0;
+    r->eating_count = st.eating_count;
+    r->waiting_to_eat = st.waiting_to_eat;
+
+    if (++b->count == DH_TRACE_BUF) dh_trace_flush(b);
+}
+
+int dh_trace_close(dh_trace_writer* w) {
+    int status = atomic_load(&w->failed) ? -1 : 0;
+
+    if (status == 0) {
+        dh_trace_footer f;
+        memcpy(f.magic, DH_TRACE_END_MAGIC, sizeof(f.magic));
+        f.records = atomic_load(&w->records);
+        if (write_all(w->fd, &f, sizeof(f)) != 0 || fsync(w->fd) != 0) status = -1;
+    }
+    if (close(w->fd) != 0) status = -1;
+    return status;
+}
+
+int dh_trace_check(const char* path, dh_trace_header* header, uint64_t* records) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    dh_trace_header h;
+    dh_trace_footer f;
+    int status = -1;
+
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)(sizeof(h) + sizeof(f))) goto out;
+    if (pread(fd, &h, sizeof(h), 0) != sizeof(h)) goto out;
+    if (pread(fd, &f, sizeof(f), st.st_size - sizeof(f)) != sizeof(f)) goto out;
+
+    if (memcmp(h.magic, DH_TRACE_MAGIC, sizeof(h.magic)) != 0 ||
+        h.version != DH_TRACE_VERSION ||
+        memcmp(f.magic, DH_TRACE_END_MAGIC, sizeof(f.magic)) != 0) {
+        goto out;
+    }
+
+    // O tamanho tem que bater com o número de registros do rodapé
+    uint64_t body = (uint64_t)st.st_size - sizeof(h) - sizeof(f);
+    if (body != f.records * sizeof(dh_trace_record)) goto out;
+
+    if (header) *header = h;
+    if (records) *records = f.records;
+    status = 0;
+
+out:
+    close(fd);
+    return status;
+}
+
+const char* dh_trace_event_name(int event) {
+    switch (event) {
+    case DH_TEV_GET_FOOD:    return "GET_FOOD";
+    case DH_TEV_REQ_ENTRY:   return "REQ_ENTRY";
+    case DH_TEV_ENTERED:     return "ENTERED";
+    case DH_TEV_ABORT_ENTRY: return "ABORT_ENTRY";
+    case DH_TEV_EATING:      return "EATING";
+    case DH_TEV_REQ_LEAVE:   return "REQ_LEAVE";
+    case DH_TEV_LEFT:        return "LEFT";
+    case DH_TEV_FINISHED:    return "FINISHED";
+    }
+    return "?";
+}
+
+static const char* event_reason(int event) {
+    switch (event) {
+    case DH_TEV_GET_FOOD:    return "Pegando comida";
+    case DH_TEV_REQ_ENTRY:   return "Tentando sentar";
+    case DH_TEV_ENTERED:     return "Conseguiu mesa";
+    case DH_TEV_ABORT_ENTRY: return "Último sobrevivente detectado";
+    case DH_TEV_EATING:      return "Comendo";
+    case DH_TEV_REQ_LEAVE:   return "Tentando sair";
+    case DH_TEV_LEFT:        return "Saiu do refeitório";
+    case DH_TEV_FINISHED:    return "Terminou todas iterações";
+    }
+    return "";
+}
+
+int dh_trace_dump(const char* path, FILE* out) {
+    dh_trace_header h;
+    uint64_t records;
+    if (dh_trace_check(path, &h, &records) != 0) return -1;
+
+    FILE* in = fopen(path, "rb");
+    if (in == NULL) return -1;
+    fseek(in, sizeof(h), SEEK_SET);
+
+    fprintf(out, "--- Trace Log Iniciado (motor=%.16s n=%u iteracoes=%u seed=%llu) ---\n",
+            h.engine, h.num_students, h.num_iterations, (unsigned long long)h.seed);
+
+    // Ordem do arquivo (blocos por thread); para ordem global: sort
+    dh_trace_record buf[1024];
+    uint64_t left = records;
+    while (left > 0) {
+        size_t want = left < 1024 ? (size_t)left : 1024;
+        size_t got = fread(buf, sizeof(dh_trace_record), want, in);
+        if (got == 0) break;
+        for (size_t i = 0; i < got; i++) {
+            uint64_t t = h.start_realtime_ns + buf[i].t_ns;
+            fprintf(out, "[%llu.%06llu] [Estudante %02u] %-15s | Eat:%d Wait:%d | %s\n",
+                    (unsigned long long)(t / 1000000000ull),
+                    (unsigned long long)(t % 1000000000ull / 1000),
+                    buf[i].student, dh_trace_event_name(buf[i].event),
+                    buf[i].eating_count, buf[i].waiting_to_eat,
+                    event_reason(buf[i].event));
+        }
+        left -= got;
+    }
+
+    fprintf(out, "--- Trace Log Finalizado ---\n");
+    fclose(in);
+    return 0;
+}
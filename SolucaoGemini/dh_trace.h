@@ -0,0 +1,124 @@
+/*
+ * dh_trace.h
+ * Formato binário de rastro (.dht) da simulação, para montar um corpus de
+ * rastros grande e reprodutível (ver trace_pipeline.c).
+ *
+ * Layout do arquivo (little-endian, tamanhos fixos):
+ *   dh_trace_header | dh_trace_record * N | dh_trace_footer
+ * O rodapé só é escrito ao final de uma rodada completa: arquivo sem
+ * rodapé válido = rodada interrompida (dh_trace_check falha).
+ *
+ * Cada thread acumula registros num dh_trace_buffer próprio e descarrega
+ * em blocos com write() em O_APPEND, então os registros de threads
+ * diferentes ficam intercalados por bloco; a ordem real é dada por t_ns.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#ifndef DH_TRACE_H
+#define DH_TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#ifdef __cplusplus
+#include <atomic>              // Mesmo layout que os _Atomic do C (GCC/Clang)
+using std::atomic_ullong;
+using std::atomic_int;
+#else
+#include <stdatomic.h>
+#endif
+
+#include "dininghall.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DH_TRACE_MAGIC     "DHTRACE1"
+#define DH_TRACE_END_MAGIC "DHTREND1"
+#define DH_TRACE_VERSION   1
+
+/* Registros por thread antes de descarregar no arquivo */
+#define DH_TRACE_BUF 64
+
+/* Eventos (mesmos nomes do log texto de dining_hall_logged.c) */
+typedef enum {
+    DH_TEV_GET_FOOD = 1,
+    DH_TEV_REQ_ENTRY,
+    DH_TEV_ENTERED,
+    DH_TEV_ABORT_ENTRY,
+    DH_TEV_EATING,
+    DH_TEV_REQ_LEAVE,
+    DH_TEV_LEFT,
+    DH_TEV_FINISHED
+} dh_trace_event;
+
+typedef struct {
+    char magic[8];             // DH_TRACE_MAGIC
+    uint32_t version;
+    uint32_t num_students;
+    uint32_t num_iterations;
+    uint32_t min_sleep_us;
+    uint32_t max_sleep_us;
+    uint32_t cpu;              // CPU em que a rodada foi fixada (-1 = nenhuma)
+    uint64_t seed;
+    uint64_t start_realtime_ns; // Relógio de parede no t_ns = 0
+    char engine[16];
+} dh_trace_header;
+
+typedef struct {
+    uint64_t t_ns;             // Desde o início da rodada (CLOCK_MONOTONIC)
+    uint32_t student;
+    uint16_t event;            // dh_trace_event
+    uint16_t reserved;
+    int32_t eating_count;      // Contadores do monitor logo após o evento
+    int32_t waiting_to_eat;    // (dh_snapshot, sem lock)
+} dh_trace_record;
+
+typedef struct {
+    char magic[8];             // DH_TRACE_END_MAGIC
+    uint64_t records;
+} dh_trace_footer;
+
+/* --- Escrita --- */
+
+typedef struct {
+    int fd;
+    uint64_t start_ns;
+    atomic_ullong records;
+    atomic_int failed;         // Algum write() falhou
+} dh_trace_writer;
+
+/* Buffer por thread; `writer` é compartilhado */
+typedef struct {
+    dh_trace_writer* writer;
+    int count;
+    dh_trace_record buf[DH_TRACE_BUF];
+} dh_trace_buffer;
+
+/* Cria/trunca `path` e grava o cabeçalho. Retorna 0 ou -1 (errno). */
+int dh_trace_open(dh_trace_writer* w, const char* path, const dh_trace_header* header);
+
+/* Registra um evento (os contadores vêm de dh_snapshot) */
+void dh_trace_emit(dh_trace_buffer* b, int student, dh_trace_event event, const dh_hall_t* hall);
+
+/* Descarrega o buffer da thread */
+void dh_trace_flush(dh_trace_buffer* b);
+
+/* Grava o rodapé, faz fsync e fecha. Retorna 0 ou -1. */
+int dh_trace_close(dh_trace_writer* w);
+
+/* --- Leitura --- */
+
+/* Rodada completa? Preenche header/records se não forem NULL. Retorna 0 ou -1. */
+int dh_trace_check(const char* path, dh_trace_header* header, uint64_t* records);
+
+/* Imprime o rastro no formato texto de dining_hall_logged.c */
+int dh_trace_dump(const char* path, FILE* out);
+
+const char* dh_trace_event_name(int event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DH_TRACE_H */
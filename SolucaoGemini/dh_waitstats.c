@@ -0,0 +1,66 @@
+/*
+ * dh_waitstats.c
+ * Tempo bloqueado por motivo, por thread (ver dh_waitstats.h).
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#define _GNU_SOURCE            // RUSAGE_THREAD
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "dh_engine.h"
+
+atomic_bool dh_waitstats_on = false;
+
+static __thread dh_waitstats_t thread_stats;
+
+static uint64_t cpu_now_ns(void) {
+    struct rusage ru;
+    if (getrusage(RUSAGE_THREAD, &ru) != 0) return 0;
+    return (uint64_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000000ull +
+           (uint64_t)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000ull;
+}
+
+static uint64_t wall_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void dh_wait_start(dh_wait_mark* m) {
+    m->wall_ns = wall_now_ns();
+    m->cpu_ns = cpu_now_ns();
+}
+
+void dh_wait_account(const dh_wait_mark* m, dh_wait_reason_t reason) {
+    uint64_t cpu = cpu_now_ns();
+    uint64_t wall = wall_now_ns();
+
+    thread_stats.count[reason]++;
+    thread_stats.wall_ns[reason] += wall - m->wall_ns;
+    // getrusage tem resolução de tick em alguns kernels: nunca passa do relógio
+    uint64_t used = cpu > m->cpu_ns ? cpu - m->cpu_ns : 0;
+    thread_stats.cpu_ns[reason] += used < wall - m->wall_ns ? used : wall - m->wall_ns;
+}
+
+void dh_waitstats_enable(bool on) {
+    atomic_store(&dh_waitstats_on, on);
+}
+
+void dh_waitstats_get(dh_waitstats_t* out) {
+    *out = thread_stats;
+}
+
+void dh_waitstats_reset(void) {
+    memset(&thread_stats, 0, sizeof(thread_stats));
+}
+
+const char* dh_wait_reason_name(int reason) {
+    switch (reason) {
+    case DH_WAIT_LOCK:    return "lock";
+    case DH_WAIT_PAIR:    return "par";
+    case DH_WAIT_BARRIER: return "barreira";
+    }
+    return "?";
+}
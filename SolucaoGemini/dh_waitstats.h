@@ -0,0 +1,59 @@
+/*
+ * dh_waitstats.h
+ * Contabilidade do tempo bloqueado dentro da libdininghall, separada por
+ * motivo da espera (dining_hall -w):
+ *
+ *   DH_WAIT_LOCK     esperando o lock do próprio monitor
+ *   DH_WAIT_PAIR     em dh_enter, esperando alguém com quem sentar
+ *   DH_WAIT_BARRIER  em dh_leave, esperando o par na barreira de saída
+ *
+ * Cada espera mede o tempo de relógio (CLOCK_MONOTONIC) e o tempo de CPU
+ * da thread (getrusage RUSAGE_THREAD, usuário + sistema); a diferença é o
+ * tempo fora da CPU. Um spin que gira esperando aparece como CPU, uma
+ * condvar/futex como fora da CPU.
+ *
+ * Desligado por padrão: cada ponto de espera custa só um teste de flag.
+ * Ligado, cada espera custa duas leituras de relógio e duas chamadas de
+ * sistema (getrusage), então os números servem para comparar motivos,
+ * não para medir o tempo absoluto de uma execução rápida.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#ifndef DH_WAITSTATS_H
+#define DH_WAITSTATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    DH_WAIT_LOCK,
+    DH_WAIT_PAIR,
+    DH_WAIT_BARRIER,
+    DH_WAIT_NUM_REASONS
+} dh_wait_reason_t;
+
+/* Totais de uma thread, por motivo */
+typedef struct {
+    uint64_t count[DH_WAIT_NUM_REASONS];
+    uint64_t wall_ns[DH_WAIT_NUM_REASONS];
+    uint64_t cpu_ns[DH_WAIT_NUM_REASONS];
+} dh_waitstats_t;
+
+/* Liga/desliga para o processo todo (ligar antes de criar as threads) */
+void dh_waitstats_enable(bool on);
+
+/* Totais da thread que chama (acumulados desde o início ou do reset) */
+void dh_waitstats_get(dh_waitstats_t* out);
+void dh_waitstats_reset(void);
+
+const char* dh_wait_reason_name(int reason);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DH_WAITSTATS_H */
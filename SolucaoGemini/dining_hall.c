@@ -1,209 +1,1412 @@
 /*
- * dining_hall.c (v2.0 - Deadlock Fix)
+ * dining_hall.c (v3.0 - libdininghall)
  * Solução Robusta para o Extended Dining Hall Problem.
  * * Correção: Adicionada lógica para abortar threads "órfãs" quando 
  * não há mais parceiros possíveis (evita Deadlock no final).
+ * * v3.0: O monitor foi extraído para a libdininghall (dininghall.h);
+ * este programa é apenas o driver da simulação.
+ * Uso: ./dining_hall [-e motor] [-m ms] [-p] [-w] [-s modo] [-t] [-a política]
+ *                     [-c lugares] [-d arquivo] [-r|-R arquivo]
+ *                     [-F semente [-k rodadas]] <numero_estudantes>
+ *      ./dining_hall [-e motor] [-s modo] [-a política] [-c lugares] -S cenário
+ *   -m ms: observador que imprime os contadores (dh_snapshot) em stderr
+ *   -p:    contadores perf_event_open (ciclos, instruções, cache misses,
+ *          trocas de contexto, CPU) por fase, agregados no final
+ *   -w:    tempo bloqueado por motivo (lock, par, barreira, random_sleep),
+ *          separando CPU de tempo fora da CPU, por estudante e no total
+ *   -s modo: sono de get_food/dine (dh_sleep.h) e relatório do atraso
+ *          (real - planejado): "rel" = nanosleep relativo (como usleep),
+ *          "abs" = prazo absoluto com folga de timer de 1ns, ou um número
+ *          = "abs" girando os últimos N µs
+ *   -t:    tempos da execução: criação das threads, carga (da largada
+ *          até o último estudante terminar) e encerramento do processo
+ *   -a pol: fixa cada estudante numa CPU (dh_place.h): none, compact,
+ *          scatter, group ou pairs
+ *   -c n:  refeitório com n lugares (dh_set_capacity; vale também no -F)
+ *   -d arq: para onde vai o dump ao vivo (padrão: stderr)
+ *   -r arq: grava o escalonamento (ordem do lock, acordares e sorteios)
+ *   -R arq: reproduz um escalonamento gravado (só motor "mutex")
+ *   -F s:   fuzzer de escalonamento (dh_fuzz.h): -k rodadas curtas (sonos
+ *           de µs em vez de ms) no mesmo processo, com perturbações nos
+ *           pontos do monitor; para na primeira que travar ou terminar
+ *           com o monitor num estado final errado
+ *   -S arq: roda um dia inteiro descrito por fases (calmaria, pico do
+ *           almoço, saída...), cada uma com população, refeições por
+ *           estudante, intervalo entre refeições e duração da refeição
+ *           (ver cenarios/dia.txt). O arquivo é lido e validado inteiro
+ *           antes de qualquer medição; cada fase roda num refeitório novo
+ *           e é medida da largada ao último estudante
+ *
+ * Dump ao vivo: `kill -USR1 <pid>` (ou Ctrl-\ = SIGQUIT) imprime, sem parar
+ * a simulação, os contadores do monitor, a fase e iteração de cada
+ * estudante, as esperas mais longas em andamento e os histogramas de
+ * latência de enter/leave (total e desde o dump anterior).
  * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
  */
 
+#define _GNU_SOURCE            // RUSAGE_THREAD, pipe2
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
 #include <unistd.h>
 #include <stdbool.h>
 #include <time.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <limits.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <math.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
-/* Constantes */
+#include "dininghall.h"
+#include "dh_perf.h"
+#include "dh_waitstats.h"
+#include "dh_sched.h"
+#include "dh_fuzz.h"
+#include "dh_sleep.h"
+#include "dh_place.h"
+
+/* Constantes (carga padrão; -S troca por fase) */
 const int NUM_ITERATIONS = 20; // Aumentei para testar mais a fundo
 const int MIN_SLEEP_MS = 10;   // Reduzi tempos para acelerar teste
 const int MAX_SLEEP_MS = 50;
 
-/* Estrutura para o Monitor do Refeitório */
+/* Distribuição de um sono: get_food (intervalo entre refeições) ou dine */
+enum { DIST_UNIFORM, DIST_EXP };
+
 typedef struct {
-    int eating_count;          
-    int waiting_to_eat;        
-    int waiting_to_leave;      
-    
-    /* NOVOS CAMPOS PARA CONTROLE DE FIM DE JOGO */
-    int total_students;        // Total de threads iniciadas
-    int finished_students;     // Quantas threads já encerraram o loop principal
-    
-    pthread_mutex_t lock;
-    pthread_cond_t ok_to_sit;
-    pthread_cond_t ok_to_leave;
-} DiningMonitor;
-
-DiningMonitor monitor;
+    int kind;
+    uint64_t min_us;           // Uniforme: [min_us, max_us]
+    uint64_t max_us;
+    uint64_t mean_us;          // Exponencial: média (cortada em EXP_CAP médias)
+} SleepDist;
 
-/* Auxiliares */
-void random_sleep(void);
-void get_food(int id);
-void dine(int id);
-
-/* Core Logic */
-bool enter_hall(int id);  // Agora retorna bool (true=sentou, false=abortou)
-void leave_hall(int id);
-void student_done(void);  // Nova função: avisa que terminou tudo
-
-/* Inicialização */
-void init_monitor(int num_students) {
-    monitor.eating_count = 0;
-    monitor.waiting_to_eat = 0;
-    monitor.waiting_to_leave = 0;
-    
-    monitor.total_students = num_students;
-    monitor.finished_students = 0;
-    
-    pthread_mutex_init(&monitor.lock, NULL);
-    pthread_cond_init(&monitor.ok_to_sit, NULL);
-    pthread_cond_init(&monitor.ok_to_leave, NULL);
-}
-
-void destroy_monitor() {
-    pthread_mutex_destroy(&monitor.lock);
-    pthread_cond_destroy(&monitor.ok_to_sit);
-    pthread_cond_destroy(&monitor.ok_to_leave);
-}
-
-/* * Tenta entrar no refeitório.
- * Retorna: true se conseguiu sentar.
- * Retorna: false se deve abortar (não há mais parceiros).
+#define EXP_CAP 20
+
+/* Carga de cada estudante */
+typedef struct {
+    int iterations;
+    SleepDist get_food;
+    SleepDist dine;
+} Workload;
+
+static Workload default_load; // Preenchida em main a partir das constantes
+
+/* -F: sonos curtos, chance de perturbar um estado novo, limite da rodada */
+const int FUZZ_MAX_SLEEP_US = 100;
+const int FUZZ_PERCENT = 50;
+const int FUZZ_ROUND_TIMEOUT_S = 5;
+
+static bool fuzz_mode = false;
+
+/* Fases de student_routine medidas com -p */
+enum { PHASE_GET_FOOD, PHASE_ENTER, PHASE_DINE, PHASE_LEAVE, NUM_PHASES };
+static const char* PHASE_NAMES[NUM_PHASES] = { "get_food", "enter_hall", "dine", "leave_hall" };
+
+typedef struct {
+    long calls;
+    dh_perf_sample total;
+} PhaseStats;
+
+/* Motivos de espera do -w: os da biblioteca e mais o random_sleep */
+enum { WAIT_SLEEP = DH_WAIT_NUM_REASONS, NUM_WAITS };
+
+typedef struct {
+    uint64_t count[NUM_WAITS];
+    uint64_t wall_ns[NUM_WAITS];
+    uint64_t cpu_ns[NUM_WAITS];
+    uint64_t thread_wall_ns;   // Vida inteira da thread
+    uint64_t thread_cpu_ns;
+} WaitStats;
+
+/* Fase atual de cada estudante, para o dump ao vivo (além de PHASE_*) */
+enum { LIVE_STARTING = NUM_PHASES, LIVE_FINISHED, NUM_LIVE };
+static const char* LIVE_NAMES[NUM_LIVE] = {
+    "get_food", "enter_hall", "dine", "leave_hall", "iniciando", "terminou"
+};
+
+typedef struct {
+    atomic_int phase;
+    atomic_int iteration;      // 1..load->iterations
+    atomic_ullong since_ns;    // Início da fase atual (CLOCK_MONOTONIC)
+} LiveState;
+
+/*
+ * Histogramas de latência de dh_enter/dh_leave, em potências de 2 de µs:
+ * balde 0 = < 1µs, balde b = [2^(b-1), 2^b) µs; o último acumula o resto.
  */
-bool enter_hall(int id) {
-    pthread_mutex_lock(&monitor.lock);
+enum { HIST_ENTER, HIST_LEAVE, NUM_HISTS };
+#define HIST_BUCKETS 24
 
-    monitor.waiting_to_eat++;
+static atomic_ulong latency_hist[NUM_HISTS][HIST_BUCKETS];
 
-    while (true) {
-        // Condição 1: Posso sentar? (Alguém comendo OU tenho par na fila)
-        bool can_sit = (monitor.eating_count > 0) || (monitor.waiting_to_eat >= 2);
-        
-        if (can_sit) {
-            break; // Sai do loop de espera e vai comer
-        }
+/*
+ * Portão de largada: as threads são criadas e param aqui; a main abre o
+ * portão depois de criar a última e todas largam juntas. Sem ele as
+ * primeiras comem sozinhas enquanto as outras ainda estão nascendo.
+ */
+typedef struct {
+    atomic_int open;           // Também é a palavra de futex
+    atomic_ullong open_ns;     // Quando a main abriu
+} Gate;
 
-        // Condição 2: Devo desistir? (Deadlock prevention)
-        // Se (Total - Finalizados) < 2, significa que sou o último (ou somos < 2), 
-        // e ninguém está comendo (eating=0). Nunca formarei par.
-        int active_students = monitor.total_students - monitor.finished_students;
-        if (monitor.eating_count == 0 && active_students < 2) {
-            monitor.waiting_to_eat--; // Sai da fila
-            pthread_mutex_unlock(&monitor.lock);
-            // printf("⚠️  [Estudante %d] Abortando: sem parceiros possíveis.\n", id);
-            return false; 
-        }
+/*
+ * Latch de término: as threads dos estudantes são destacadas (detached) e
+ * cada uma decrementa o latch como última coisa que faz; a última marca o
+ * fim da carga e acorda a main, que espera numa palavra só em vez de dar
+ * join em N threads na ordem de criação.
+ */
+typedef struct {
+    atomic_int remaining;      // Estudantes que ainda não terminaram
+    atomic_ullong end_ns;      // Quando o último estudante terminou
+    atomic_int done;           // 1 = end_ns pronto; palavra de futex da main
+} Latch;
+
+/* Argumento de cada thread de estudante */
+typedef struct {
+    int id;
+    dh_hall_t* hall;
+    const Workload* load;
+    long meals;
+
+    /* -p: contadores desta thread (grupo aberto pela própria thread) */
+    bool profile;
+    dh_perf_group group;
+    int perf_errno;            // Motivo, se nenhum contador abriu
+    dh_perf_group opened;      // Cópia do grupo antes de fechar (o que abriu)
+    PhaseStats phases[NUM_PHASES];
+
+    /* -w: tempo bloqueado desta thread */
+    bool waits_on;
+    WaitStats waits;
+
+    LiveState live;
+
+    dh_sleep_stats_t sleeps;   // -s: planejado x real dos sonos desta thread
+
+    int cpu;                   // -a: CPU onde fixar (-1 = livre)
+    Gate* gate;
+    Latch* latch;
+} StudentArgs;
+
+/* Auxiliares */
+void random_sleep(int id, const SleepDist* dist);
+void get_food(int id, const Workload* load);
+void dine(int id, const Workload* load);
+void* student_routine(void* arg);
 
-        // Se não posso sentar nem preciso desistir, espero.
-        pthread_cond_wait(&monitor.ok_to_sit, &monitor.lock);
+void random_sleep(int id, const SleepDist* dist) {
+    // Sorteio gravado/reproduzido com -r/-R
+    unsigned r = dh_sched_rand(id, (unsigned)rand());
+    if (fuzz_mode) {
+        dh_sleep_ns((uint64_t)(r % (FUZZ_MAX_SLEEP_US + 1)) * 1000);
+        return;
     }
+    uint64_t us;
+    if (dist->kind == DIST_EXP) {
+        double u = (double)r / ((double)RAND_MAX + 1.0);
+        double x = -log(1.0 - u);
+        us = (uint64_t)(dist->mean_us * (x < EXP_CAP ? x : EXP_CAP));
+    } else {
+        us = dist->min_us + r % (dist->max_us - dist->min_us + 1);
+    }
+    dh_sleep_ns(us * 1000);
+}
 
-    monitor.waiting_to_eat--;
-    monitor.eating_count++;
+void get_food(int id, const Workload* load) { random_sleep(id, &load->get_food); }
+void dine(int id, const Workload* load) { random_sleep(id, &load->dine); }
 
-    // printf("🟢 [Estudante %d] SENTOU. (Comendo: %d)\n", id, monitor.eating_count);
+/* Observador: lê o retrato sem lock, nunca atrasa os estudantes */
+typedef struct {
+    dh_hall_t* hall;
+    int interval_ms;
+    volatile bool stop;
+} ObserverArgs;
 
-    // Acorda o próximo (meu par ou alguém extra)
-    pthread_cond_signal(&monitor.ok_to_sit);
+void* observer_routine(void* arg) {
+    ObserverArgs* obs = arg;
+    while (!obs->stop) {
+        dh_stats_t st;
+        dh_snapshot(obs->hall, &st);
+        fprintf(stderr, "[observador v%u] Eat:%d Wait:%d Leave:%d Fim:%d/%d\n",
+                st.version, st.eating_count, st.waiting_to_eat,
+                st.waiting_to_leave, st.finished_students, st.total_students);
+        usleep(obs->interval_ms * 1000);
+    }
+    return NULL;
+}
 
-    pthread_mutex_unlock(&monitor.lock);
-    return true;
+/* Relógio monotônico e (-w) CPU da thread (usuário + sistema) */
+static uint64_t wall_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
 }
 
-void leave_hall(int id) {
-    pthread_mutex_lock(&monitor.lock);
+static uint64_t cpu_now_ns(void) {
+    struct rusage ru;
+    if (getrusage(RUSAGE_THREAD, &ru) != 0) return 0;
+    return (uint64_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000000ull +
+           (uint64_t)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000ull;
+}
 
-    if (monitor.eating_count == 2) {
-        monitor.waiting_to_leave++;
-        while (monitor.waiting_to_leave < 2 && monitor.eating_count == 2) {
-            pthread_cond_wait(&monitor.ok_to_leave, &monitor.lock);
-        }
-        monitor.waiting_to_leave--;
+static void futex_wait(atomic_int* word, int val, const struct timespec* timeout) {
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, val, timeout, NULL, 0);
+}
+
+static void futex_wake(atomic_int* word, int count) {
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+static void gate_init(Gate* gate) {
+    atomic_init(&gate->open, 0);
+    atomic_init(&gate->open_ns, 0);
+}
+
+static void gate_wait(Gate* gate) {
+    while (atomic_load_explicit(&gate->open, memory_order_acquire) == 0) {
+        futex_wait(&gate->open, 0, NULL);
     }
+}
+
+/* Abre o portão para todos de uma vez; retorna o instante da largada */
+static uint64_t gate_open(Gate* gate) {
+    uint64_t now = wall_now_ns();
+    atomic_store_explicit(&gate->open_ns, now, memory_order_relaxed);
+    atomic_store_explicit(&gate->open, 1, memory_order_release);
+    futex_wake(&gate->open, INT_MAX);
+    return now;
+}
+
+static void latch_init(Latch* latch, int count) {
+    atomic_init(&latch->remaining, count);
+    atomic_init(&latch->end_ns, 0);
+    atomic_init(&latch->done, 0);
+}
 
-    monitor.eating_count--;
-    // printf("🔴 [Estudante %d] SAIU.\n", id);
+/*
+ * O último grava end_ns e só então publica `done`: a partir daí a main
+ * pode retornar e reaproveitar o latch (o da próxima rodada fica no mesmo
+ * endereço), então nada do latch é escrito depois. O wake pode cair num
+ * endereço já reaproveitado; quem espera em futex sempre reconfere.
+ */
+static void latch_count_down(Latch* latch) {
+    // Lê o relógio antes: o último a chegar já está com o fim da carga
+    uint64_t now = wall_now_ns();
+    if (atomic_fetch_sub_explicit(&latch->remaining, 1, memory_order_acq_rel) == 1) {
+        atomic_store_explicit(&latch->end_ns, now, memory_order_relaxed);
+        atomic_store_explicit(&latch->done, 1, memory_order_release);
+        futex_wake(&latch->done, 1);
+    }
+}
 
-    pthread_cond_broadcast(&monitor.ok_to_leave);
-    pthread_cond_signal(&monitor.ok_to_sit);
+/*
+ * Espera o latch zerar até `deadline_ns` (CLOCK_MONOTONIC; 0 = sem prazo).
+ * Retorna false se o prazo passou.
+ */
+static bool latch_wait(Latch* latch, uint64_t deadline_ns) {
+    while (true) {
+        if (atomic_load_explicit(&latch->done, memory_order_acquire)) return true;
 
-    pthread_mutex_unlock(&monitor.lock);
+        struct timespec rel, *timeout = NULL;
+        if (deadline_ns) {
+            uint64_t now = wall_now_ns();
+            if (now >= deadline_ns) return false;
+            rel.tv_sec = (time_t)((deadline_ns - now) / 1000000000ull);
+            rel.tv_nsec = (long)((deadline_ns - now) % 1000000000ull);
+            timeout = &rel;
+        }
+        futex_wait(&latch->done, 0, timeout);
+    }
 }
 
-/* * Função chamada quando o estudante termina TODAS as iterações.
- * Importante para avisar os que sobraram que "não vem mais ninguém".
+/*
+ * Estudantes rodam destacados: ninguém dá join, o latch diz quando
+ * acabaram. Cria todos atrás do portão e abre; retorna a largada.
  */
-void student_done() {
-    pthread_mutex_lock(&monitor.lock);
-    monitor.finished_students++;
-    
-    // ACORDA TODOS: Quem estiver esperando em enter_hall precisa acordar
-    // para checar a condição de aborto (active_students < 2).
-    pthread_cond_broadcast(&monitor.ok_to_sit);
-    
-    pthread_mutex_unlock(&monitor.lock);
+static uint64_t start_students(StudentArgs* args, int num_students, Gate* gate) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    for (int i = 0; i < num_students; i++) {
+        pthread_t thread;
+        args[i].gate = gate;
+        int err = pthread_create(&thread, &attr, student_routine, &args[i]);
+        if (err != 0) {
+            fprintf(stderr, "Erro: não consegui criar o estudante %d de %d: %s\n",
+                    i + 1, num_students, strerror(err));
+            // O refeitório conta com todos: os já criados esperariam no
+            // portão (e o latch por eles) para sempre
+            _exit(1);
+        }
+    }
+    pthread_attr_destroy(&attr);
+    return gate_open(gate);
+}
+
+/* -w: random_sleep medido como espera (get_food e dine) */
+static void sleep_phase(StudentArgs* args, void (*phase)(int, const Workload*), int id) {
+    if (!args->waits_on) {
+        phase(id, args->load);
+        return;
+    }
+    uint64_t wall = wall_now_ns(), cpu = cpu_now_ns();
+    phase(id, args->load);
+    args->waits.count[WAIT_SLEEP]++;
+    args->waits.wall_ns[WAIT_SLEEP] += wall_now_ns() - wall;
+    args->waits.cpu_ns[WAIT_SLEEP] += cpu_now_ns() - cpu;
+}
+
+/* Muda a fase ao vivo; retorna o tempo gasto na fase anterior */
+static uint64_t live_phase(StudentArgs* args, int phase) {
+    uint64_t now = wall_now_ns();
+    uint64_t since = atomic_exchange_explicit(&args->live.since_ns, now, memory_order_relaxed);
+    atomic_store_explicit(&args->live.phase, phase, memory_order_relaxed);
+    return now - since;
 }
 
-void random_sleep() {
-    int ms = MIN_SLEEP_MS + rand() % (MAX_SLEEP_MS - MIN_SLEEP_MS + 1);
-    usleep(ms * 1000);
+static void hist_add(int hist, uint64_t ns) {
+    uint64_t us = ns / 1000;
+    int b = 0;
+    while (us > 0 && b < HIST_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    atomic_fetch_add_explicit(&latency_hist[hist][b], 1, memory_order_relaxed);
+}
+
+/* Soma na fase o quanto os contadores andaram desde `mark` (-p) */
+static void phase_account(StudentArgs* args, int phase, dh_perf_sample* mark) {
+    if (args->group.nr == 0) return;
+
+    dh_perf_sample now;
+    if (!dh_perf_read(&args->group, &now)) return;
+    for (int c = 0; c < DH_PERF_NUM_COUNTERS; c++) {
+        args->phases[phase].total.v[c] += now.v[c] - mark->v[c];
+    }
+    args->phases[phase].calls++;
+    *mark = now;
 }
 
-void get_food(int id) { random_sleep(); }
-void dine(int id) { random_sleep(); }
+/* -a: a primeira fixação que falhar avisa (uma vez por processo) */
+static atomic_flag place_warned = ATOMIC_FLAG_INIT;
 
 void* student_routine(void* arg) {
-    int id = *(int*)arg;
-    free(arg);
+    StudentArgs* args = arg;
+    int id = args->id;
+    dh_hall_t* hall = args->hall;
+
+    // Fixa na CPU antes da largada, para largar já no lugar
+    if (dh_place_self(args->cpu) != 0 && !atomic_flag_test_and_set(&place_warned)) {
+        fprintf(stderr, "Aviso: não fixei o estudante %d na CPU %d (%s); -a não vale para todos.\n",
+                id, args->cpu, strerror(errno));
+    }
+
+    // Espera a largada: nada desta thread conta antes dela
+    gate_wait(args->gate);
+
+    uint64_t start_wall = 0, start_cpu = 0;
+    if (args->waits_on) {
+        start_wall = wall_now_ns();
+        start_cpu = cpu_now_ns();
+    }
 
-    for (int i = 0; i < NUM_ITERATIONS; i++) {
-        get_food(id);
+    dh_perf_sample mark;
+    args->group.nr = 0;
+    if (args->profile) {
+        if (dh_perf_open(&args->group, &args->perf_errno) > 0) {
+            dh_perf_read(&args->group, &mark);
+        }
+    }
+
+    for (int i = 0; i < args->load->iterations; i++) {
+        atomic_store_explicit(&args->live.iteration, i + 1, memory_order_relaxed);
+        live_phase(args, PHASE_GET_FOOD);
+        sleep_phase(args, get_food, id);
+        phase_account(args, PHASE_GET_FOOD, &mark);
         
         // Tenta entrar. Se retornar false, aborta o loop inteiro.
-        if (!enter_hall(id)) {
+        live_phase(args, PHASE_ENTER);
+        bool sat = dh_enter(hall, id);
+        phase_account(args, PHASE_ENTER, &mark);
+        if (!sat) {
             break; 
         }
         
-        dine(id);
-        leave_hall(id);
+        hist_add(HIST_ENTER, live_phase(args, PHASE_DINE));
+        sleep_phase(args, dine, id);
+        phase_account(args, PHASE_DINE, &mark);
+        live_phase(args, PHASE_LEAVE);
+        dh_leave(hall, id);
+        phase_account(args, PHASE_LEAVE, &mark);
+        hist_add(HIST_LEAVE, live_phase(args, PHASE_GET_FOOD));
+        args->meals++;
     }
 
     // Marca presença como finalizado antes de morrer
-    student_done();
+    dh_done(hall, id);
+    live_phase(args, LIVE_FINISHED);
+    dh_sleep_get(&args->sleeps);
+    args->opened = args->group;
+    if (args->group.nr > 0) dh_perf_close(&args->group);
+
+    if (args->waits_on) {
+        args->waits.thread_wall_ns = wall_now_ns() - start_wall;
+        args->waits.thread_cpu_ns = cpu_now_ns() - start_cpu;
+        dh_waitstats_t lib;
+        dh_waitstats_get(&lib);
+        for (int r = 0; r < DH_WAIT_NUM_REASONS; r++) {
+            args->waits.count[r] = lib.count[r];
+            args->waits.wall_ns[r] = lib.wall_ns[r];
+            args->waits.cpu_ns[r] = lib.cpu_ns[r];
+        }
+    }
+
+    // Por último: depois daqui a main pode liberar `args`
+    latch_count_down(args->latch);
+    return NULL;
+}
+
+/* -p: agrega as fases de todas as threads e imprime a média por chamada */
+void print_phase_report(StudentArgs* args, int num_students) {
+    PhaseStats total[NUM_PHASES];
+    memset(total, 0, sizeof(total));
+
+    // Contador disponível = abriu em alguma thread (o grupo é igual em todas)
+    bool has[DH_PERF_NUM_COUNTERS] = { false };
+    bool user_only = false;
+    int profiled = 0, perf_errno = 0;
+
+    for (int i = 0; i < num_students; i++) {
+        if (args[i].perf_errno && perf_errno == 0) perf_errno = args[i].perf_errno;
+        bool any = false;
+        for (int p = 0; p < NUM_PHASES; p++) {
+            total[p].calls += args[i].phases[p].calls;
+            for (int c = 0; c < DH_PERF_NUM_COUNTERS; c++) {
+                total[p].total.v[c] += args[i].phases[p].total.v[c];
+            }
+            if (args[i].phases[p].calls > 0) any = true;
+        }
+        if (!any) continue;
+        profiled++;
+        for (int c = 0; c < DH_PERF_NUM_COUNTERS; c++) {
+            if (dh_perf_has(&args[i].opened, c)) has[c] = true;
+        }
+        if (args[i].opened.user_only) user_only = true;
+    }
+
+    if (profiled == 0) {
+        printf("-p: perf_event_open indisponível (%s); nada medido.\n",
+               perf_errno ? strerror(perf_errno) : "sem contadores");
+        return;
+    }
+
+    printf("--- Contadores por fase: média por chamada, %d threads%s ---\n",
+           profiled, user_only ? ", só modo usuário" : "");
+    printf("%-11s %9s", "fase", "chamadas");
+    for (int c = 0; c < DH_PERF_NUM_COUNTERS; c++) printf(" %13s", dh_perf_counter_name(c));
+    printf("\n");
+
+    for (int p = 0; p < NUM_PHASES; p++) {
+        double calls = total[p].calls > 0 ? (double)total[p].calls : 1.0;
+        printf("%-11s %9ld", PHASE_NAMES[p], total[p].calls);
+        for (int c = 0; c < DH_PERF_NUM_COUNTERS; c++) {
+            if (has[c]) printf(" %13.1f", total[p].total.v[c] / calls);
+            else printf(" %13s", "n/d");
+        }
+        printf("\n");
+    }
+}
+
+static const char* wait_name(int w) {
+    return w == WAIT_SLEEP ? "random_sleep" : dh_wait_reason_name(w);
+}
+
+static double ms(uint64_t ns) { return ns / 1e6; }
+
+static uint64_t off_cpu_ns(uint64_t wall, uint64_t cpu) {
+    return wall > cpu ? wall - cpu : 0;
+}
+
+/* Estudantes em ordem decrescente de tempo fora da CPU */
+static const StudentArgs* by_off_cpu_args;
+
+static int cmp_off_cpu(const void* a, const void* b) {
+    const WaitStats* x = &by_off_cpu_args[*(const int*)a].waits;
+    const WaitStats* y = &by_off_cpu_args[*(const int*)b].waits;
+    uint64_t ox = off_cpu_ns(x->thread_wall_ns, x->thread_cpu_ns);
+    uint64_t oy = off_cpu_ns(y->thread_wall_ns, y->thread_cpu_ns);
+    return (ox < oy) - (ox > oy);
+}
+
+/*
+ * -w: total da execução por motivo (o que sobra do tempo das threads é
+ * trabalho fora das esperas) e, por estudante, onde o tempo foi parar.
+ * Com mais de 20 estudantes, só os 10 que mais ficaram fora da CPU.
+ */
+void print_wait_report(StudentArgs* args, int num_students) {
+    WaitStats total;
+    memset(&total, 0, sizeof(total));
+    for (int i = 0; i < num_students; i++) {
+        for (int w = 0; w < NUM_WAITS; w++) {
+            total.count[w] += args[i].waits.count[w];
+            total.wall_ns[w] += args[i].waits.wall_ns[w];
+            total.cpu_ns[w] += args[i].waits.cpu_ns[w];
+        }
+        total.thread_wall_ns += args[i].waits.thread_wall_ns;
+        total.thread_cpu_ns += args[i].waits.thread_cpu_ns;
+    }
+
+    double all = total.thread_wall_ns > 0 ? (double)total.thread_wall_ns : 1.0;
+    printf("--- Tempo bloqueado por motivo: soma de %d threads ---\n", num_students);
+    printf("%-18s %9s %12s %12s %12s %7s\n",
+           "motivo", "esperas", "parado(ms)", "cpu(ms)", "fora cpu(ms)", "%tempo");
+
+    uint64_t waited_wall = 0, waited_cpu = 0;
+    for (int w = 0; w < NUM_WAITS; w++) {
+        printf("%-18s %9llu %12.1f %12.1f %12.1f %6.1f%%\n", wait_name(w),
+               (unsigned long long)total.count[w], ms(total.wall_ns[w]), ms(total.cpu_ns[w]),
+               ms(off_cpu_ns(total.wall_ns[w], total.cpu_ns[w])), 100.0 * total.wall_ns[w] / all);
+        waited_wall += total.wall_ns[w];
+        waited_cpu += total.cpu_ns[w];
+    }
+    uint64_t rest_wall = off_cpu_ns(total.thread_wall_ns, waited_wall);
+    uint64_t rest_cpu = off_cpu_ns(total.thread_cpu_ns, waited_cpu);
+    printf("%-18s %9s %12.1f %12.1f %12.1f %6.1f%%\n", "(fora das esperas)", "",
+           ms(rest_wall), ms(rest_cpu), ms(off_cpu_ns(rest_wall, rest_cpu)), 100.0 * rest_wall / all);
+    printf("%-18s %9s %12.1f %12.1f %12.1f %6.1f%%\n", "total", "",
+           ms(total.thread_wall_ns), ms(total.thread_cpu_ns),
+           ms(off_cpu_ns(total.thread_wall_ns, total.thread_cpu_ns)), 100.0);
+
+    int* order = malloc(sizeof(int) * num_students);
+    for (int i = 0; i < num_students; i++) order[i] = i;
+    int shown = num_students;
+    if (num_students > 20) {
+        by_off_cpu_args = args;
+        qsort(order, num_students, sizeof(int), cmp_off_cpu);
+        shown = 10;
+        printf("--- Por estudante (ms): os %d mais tempo fora da CPU ---\n", shown);
+    } else {
+        printf("--- Por estudante (ms) ---\n");
+    }
+
+    printf("%-10s %10s %10s %10s", "estudante", "vida", "cpu", "fora cpu");
+    for (int w = 0; w < NUM_WAITS; w++) printf(" %12.12s", wait_name(w));
+    printf("\n");
+    for (int k = 0; k < shown; k++) {
+        const WaitStats* ws = &args[order[k]].waits;
+        printf("%-10d %10.1f %10.1f %10.1f", args[order[k]].id, ms(ws->thread_wall_ns),
+               ms(ws->thread_cpu_ns), ms(off_cpu_ns(ws->thread_wall_ns, ws->thread_cpu_ns)));
+        for (int w = 0; w < NUM_WAITS; w++) printf(" %12.1f", ms(ws->wall_ns[w]));
+        printf("\n");
+    }
+    free(order);
+}
+
+/* Limite superior (µs) do balde b do histograma de atraso */
+static uint64_t sleep_bucket_us(int b) {
+    return b == 0 ? 1 : 1ull << b;
+}
+
+/* Menor balde que cobre a fração `q` dos sonos */
+static int sleep_quantile(const dh_sleep_stats_t* st, double q) {
+    uint64_t want = (uint64_t)(q * st->count + 0.999999), seen = 0;
+    for (int b = 0; b < DH_SLEEP_HIST_BUCKETS; b++) {
+        seen += st->hist[b];
+        if (seen >= want) return b;
+    }
+    return DH_SLEEP_HIST_BUCKETS - 1;
+}
+
+/* -s: atraso dos sonos (real - planejado), somando todas as threads */
+void print_sleep_report(StudentArgs* args, int num_students, const char* mode) {
+    dh_sleep_stats_t total;
+    memset(&total, 0, sizeof(total));
+    for (int i = 0; i < num_students; i++) {
+        const dh_sleep_stats_t* st = &args[i].sleeps;
+        total.count += st->count;
+        total.planned_ns += st->planned_ns;
+        total.actual_ns += st->actual_ns;
+        if (st->max_over_ns > total.max_over_ns) total.max_over_ns = st->max_over_ns;
+        for (int b = 0; b < DH_SLEEP_HIST_BUCKETS; b++) total.hist[b] += st->hist[b];
+    }
+    if (total.count == 0) return;
+
+    double n = (double)total.count;
+    uint64_t over = total.actual_ns > total.planned_ns ? total.actual_ns - total.planned_ns : 0;
+    printf("--- Sono (%s): %llu sonos, planejado %.3f ms, real %.3f ms em média ---\n", mode,
+           (unsigned long long)total.count, ms(total.planned_ns) / n, ms(total.actual_ns) / n);
+    printf("atraso: média %.1f µs (%.2f%% do planejado), p50 < %llu µs, p99 < %llu µs, "
+           "máx %.1f µs\n", over / n / 1000.0,
+           total.planned_ns > 0 ? 100.0 * over / total.planned_ns : 0.0,
+           (unsigned long long)sleep_bucket_us(sleep_quantile(&total, 0.50)),
+           (unsigned long long)sleep_bucket_us(sleep_quantile(&total, 0.99)),
+           total.max_over_ns / 1000.0);
+}
+
+/* --- Dump ao vivo (SIGUSR1/SIGQUIT) --- */
+
+/*
+ * O tratador de sinal só escreve o número do sinal num pipe (self-pipe);
+ * quem monta o relatório é a thread reporter, fora do contexto do sinal.
+ * Os sinais ficam bloqueados em todas as outras threads, para nunca
+ * interromper um sono ou uma espera dos estudantes.
+ */
+static int dump_pipe[2] = { -1, -1 };
+
+static void dump_signal_handler(int sig) {
+    int saved = errno;
+    unsigned char b = (unsigned char)sig;
+    ssize_t n = write(dump_pipe[1], &b, 1); // Pipe cheio: esse dump se perde
+    (void)n;
+    errno = saved;
+}
+
+typedef struct {
+    dh_hall_t* hall;
+    StudentArgs* args;
+    int num_students;
+    FILE* out;
+    uint64_t start_ns;
+    unsigned long last[NUM_HISTS][HIST_BUCKETS]; // Histograma no dump anterior
+} Reporter;
+
+/* Estudantes que mostramos um a um; acima disso, só o resumo por fase */
+#define DUMP_MAX_STUDENTS 64
+#define DUMP_TOP_WAITERS 5
+
+static void dump_state(Reporter* rep, const char* why) {
+    FILE* out = rep->out;
+    uint64_t now = wall_now_ns();
+
+    dh_stats_t st;
+    dh_snapshot(rep->hall, &st);
+    fprintf(out, "=== Dump ao vivo (%s) t=%.3fs motor=%s ===\n",
+            why, (now - rep->start_ns) / 1e9,
+            dh_engine_name(rep->hall));
+    fprintf(out, "Monitor v%u: Eat:%d Wait:%d Leave:%d Fim:%d/%d\n",
+            st.version, st.eating_count, st.waiting_to_eat,
+            st.waiting_to_leave, st.finished_students, st.total_students);
+
+    // Fase de cada estudante e as esperas (enter/leave) mais longas agora
+    int per_phase[NUM_LIVE] = { 0 };
+    int top[DUMP_TOP_WAITERS];
+    uint64_t top_ns[DUMP_TOP_WAITERS];
+    int ntop = 0;
+    bool each = rep->num_students <= DUMP_MAX_STUDENTS;
+    if (each) fprintf(out, "Estudantes (fase, iteração, tempo na fase):\n");
+
+    for (int i = 0; i < rep->num_students; i++) {
+        LiveState* live = &rep->args[i].live;
+        int phase = atomic_load_explicit(&live->phase, memory_order_relaxed);
+        int it = atomic_load_explicit(&live->iteration, memory_order_relaxed);
+        uint64_t since = atomic_load_explicit(&live->since_ns, memory_order_relaxed);
+        uint64_t in_phase = now > since ? now - since : 0;
+        per_phase[phase]++;
+
+        if (each) {
+            fprintf(out, "  %02d %-10s it %2d/%d %10.1fms\n", rep->args[i].id,
+                    LIVE_NAMES[phase], it, rep->args[i].load->iterations, in_phase / 1e6);
+        }
+
+        if (phase != PHASE_ENTER && phase != PHASE_LEAVE) continue;
+        // Inserção ordenada (decrescente) nas DUMP_TOP_WAITERS maiores
+        int k = ntop < DUMP_TOP_WAITERS ? ntop++ : DUMP_TOP_WAITERS;
+        while (k > 0 && top_ns[k - 1] < in_phase) {
+            if (k < DUMP_TOP_WAITERS) {
+                top[k] = top[k - 1];
+                top_ns[k] = top_ns[k - 1];
+            }
+            k--;
+        }
+        if (k < DUMP_TOP_WAITERS) {
+            top[k] = i;
+            top_ns[k] = in_phase;
+        }
+    }
+
+    fprintf(out, "Fases:");
+    for (int p = 0; p < NUM_LIVE; p++) fprintf(out, " %s=%d", LIVE_NAMES[p], per_phase[p]);
+    fprintf(out, "\n");
+
+    fprintf(out, "Esperas mais longas em andamento:%s\n", ntop ? "" : " nenhuma");
+    for (int k = 0; k < ntop; k++) {
+        StudentArgs* a = &rep->args[top[k]];
+        fprintf(out, "  Estudante %02d %-10s %10.1fms (it %d)\n", a->id,
+                LIVE_NAMES[atomic_load_explicit(&a->live.phase, memory_order_relaxed)],
+                top_ns[k] / 1e6, atomic_load_explicit(&a->live.iteration, memory_order_relaxed));
+    }
+
+    fprintf(out, "Latência (µs)        enter: total  recente  leave: total  recente\n");
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        unsigned long v[NUM_HISTS], d[NUM_HISTS];
+        for (int h = 0; h < NUM_HISTS; h++) {
+            v[h] = atomic_load_explicit(&latency_hist[h][b], memory_order_relaxed);
+            d[h] = v[h] - rep->last[h][b];
+            rep->last[h][b] = v[h];
+        }
+        if (v[HIST_ENTER] == 0 && v[HIST_LEAVE] == 0) continue;
+
+        char range[32];
+        if (b == 0) snprintf(range, sizeof(range), "< 1");
+        else if (b == 1) snprintf(range, sizeof(range), "1");
+        else if (b == HIST_BUCKETS - 1) snprintf(range, sizeof(range), ">= %lu", 1ul << (b - 1));
+        else snprintf(range, sizeof(range), "%lu-%lu", 1ul << (b - 1), (1ul << b) - 1);
+        fprintf(out, "  %-18s %12lu %8lu %13lu %8lu\n", range,
+                v[HIST_ENTER], d[HIST_ENTER], v[HIST_LEAVE], d[HIST_LEAVE]);
+    }
+    fprintf(out, "=== Fim do dump ===\n");
+    fflush(out);
+}
+
+void* reporter_routine(void* arg) {
+    Reporter* rep = arg;
+
+    // Só esta thread recebe os sinais de dump
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    sigaddset(&set, SIGQUIT);
+    pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+
+    while (true) {
+        unsigned char b;
+        ssize_t n = read(dump_pipe[0], &b, 1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0 || b == 0) break; // 0 = fim da simulação
+        dump_state(rep, b == SIGQUIT ? "SIGQUIT" : "SIGUSR1");
+    }
     return NULL;
 }
 
+/* Instala o dump; retorna false se não deu (a simulação roda sem ele) */
+static bool dump_start(Reporter* rep, pthread_t* thread) {
+    if (pipe2(dump_pipe, O_CLOEXEC) != 0) return false;
+    // O tratador nunca pode bloquear num pipe cheio
+    fcntl(dump_pipe[1], F_SETFL, O_NONBLOCK);
+
+    // Bloqueia antes de criar qualquer thread: todas herdam a máscara
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    sigaddset(&set, SIGQUIT);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = dump_signal_handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR1, &sa, NULL);
+    sigaction(SIGQUIT, &sa, NULL);
+
+    return pthread_create(thread, NULL, reporter_routine, rep) == 0;
+}
+
+/*
+ * O pipe pode estar cheio de sinais ainda não lidos (e a ponta de escrita
+ * não bloqueia): espera a thread do dump esvaziar e tenta de novo. Tirar o
+ * O_NONBLOCK não serve, o tratador roda na própria thread que lê.
+ */
+static void dump_stop(pthread_t thread) {
+    unsigned char stop = 0;
+    while (write(dump_pipe[1], &stop, 1) < 0) {
+        if (errno == EAGAIN) {
+            struct pollfd pfd = { .fd = dump_pipe[1], .events = POLLOUT };
+            poll(&pfd, 1, -1);
+        } else if (errno != EINTR) {
+            break;
+        }
+    }
+    pthread_join(thread, NULL);
+}
+
+/* --- Fuzzer (-F) --- */
+
+/*
+ * Roda `rounds` rodadas com sementes seed, seed+1, ... Cada rodada é um
+ * refeitório novo; a cobertura de estados do fuzzer acumula entre elas.
+ * Retorna 0 se todas terminaram bem, 2 na primeira que falhou.
+ */
+int fuzz_main(const char* engine, int num_students, int seats, uint64_t seed, long rounds) {
+    fuzz_mode = true;
+    StudentArgs* args = malloc(sizeof(StudentArgs) * num_students);
+    uint64_t start = wall_now_ns();
+    unsigned last_states = 0;
+    int status = 0;
+
+    for (long r = 0; r < rounds && status == 0; r++) {
+        uint64_t round_seed = seed + (uint64_t)r;
+        dh_hall_t* hall = dh_create_engine(engine, num_students);
+        if (hall == NULL) {
+            fprintf(stderr, "Erro: motor desconhecido '%s'.\n", engine ? engine : "(padrão)");
+            status = 1;
+            break;
+        }
+        dh_set_capacity(hall, seats);
+
+        dh_fuzz_enable(round_seed, FUZZ_PERCENT);
+        srand((unsigned)round_seed);
+        memset(args, 0, sizeof(StudentArgs) * num_students);
+        uint64_t round_start = wall_now_ns();
+        Gate gate;
+        Latch latch;
+        gate_init(&gate);
+        latch_init(&latch, num_students);
+        for (int i = 0; i < num_students; i++) {
+            args[i].id = i + 1;
+            args[i].hall = hall;
+            args[i].load = &default_load;
+            args[i].latch = &latch;
+            args[i].cpu = -1;
+            atomic_init(&args[i].live.phase, LIVE_STARTING);
+            atomic_init(&args[i].live.since_ns, round_start);
+        }
+        start_students(args, num_students, &gate);
+
+        // Rodada que não termina no prazo = travou (deadlock ou acordar perdido)
+        Reporter rep = { .hall = hall, .args = args, .num_students = num_students,
+                         .out = stderr, .start_ns = round_start };
+        if (!latch_wait(&latch, round_start + FUZZ_ROUND_TIMEOUT_S * 1000000000ull)) {
+            fprintf(stderr, "FUZZ: rodada %ld (semente %llu) travou\n",
+                    r, (unsigned long long)round_seed);
+            dump_state(&rep, "fuzzer: rodada travada");
+            fflush(stdout);
+            _exit(2); // Threads presas no monitor: não dá para destruir o refeitório
+        }
+
+        // Oráculo do fim: ninguém comendo nem esperando, todos encerrados.
+        // No rcl o servidor publica depois de concluir os pedidos: o retrato
+        // pode vir uma publicação atrasado logo após o join, então espera
+        // ele assentar (até ~1s) antes de acusar.
+        dh_stats_t st;
+        for (int tries = 0; tries < 1000; tries++) {
+            dh_snapshot(hall, &st);
+            if (st.eating_count == 0 && st.waiting_to_eat == 0 && st.waiting_to_leave == 0 &&
+                st.finished_students == num_students) {
+                break;
+            }
+            usleep(1000);
+        }
+        unsigned long violations = dh_check_violations(hall);
+        if (violations > 0) {
+            fprintf(stderr, "FUZZ: rodada %ld (semente %llu) violou os invariantes %lu vez(es)\n",
+                    r, (unsigned long long)round_seed, violations);
+            status = 2;
+        } else if (st.eating_count != 0 || st.waiting_to_eat != 0 || st.waiting_to_leave != 0 ||
+            st.finished_students != num_students) {
+            fprintf(stderr, "FUZZ: rodada %ld (semente %llu) terminou com o monitor em "
+                    "Eat:%d Wait:%d Leave:%d Fim:%d/%d\n", r, (unsigned long long)round_seed,
+                    st.eating_count, st.waiting_to_eat, st.waiting_to_leave,
+                    st.finished_students, st.total_students);
+            status = 2;
+        }
+        dh_destroy(hall);
+
+        dh_fuzz_stats_t fs;
+        dh_fuzz_stats(&fs);
+        if (fs.states != last_states || (r + 1) % 1000 == 0) {
+            printf("rodada %6ld  %7.2fs  estados %u/%u%s\n", r + 1, (wall_now_ns() - start) / 1e9,
+                   fs.states, fs.possible, fs.states != last_states ? "  (novos)" : "");
+            last_states = fs.states;
+        }
+    }
+
+    dh_fuzz_disable();
+    dh_fuzz_stats_t fs;
+    dh_fuzz_stats(&fs);
+    printf("--- Fuzzer: %s, %d estudantes, %.2fs, %u/%u estados, %llu/%llu pontos perturbados ---\n",
+           status == 0 ? "nenhuma falha" : "FALHOU", num_students, (wall_now_ns() - start) / 1e9,
+           fs.states, fs.possible, fs.perturbed, fs.points);
+
+    free(args);
+    return status;
+}
+
+/* --- Cenários (-S) --- */
+
+#define MAX_PHASES 32
+
+typedef struct {
+    char name[32];
+    int num_students;
+    int seats;                 // -1 = o do -c
+    Workload load;
+} Phase;
+
+/* "20:60" ou "uniforme:20:60" (ms, aceita fração) ou "exp:40" (média em ms) */
+static bool parse_dist(const char* str, SleepDist* dist) {
+    char* end;
+    if (strncmp(str, "exp:", 4) == 0) {
+        double mean = strtod(str + 4, &end);
+        if (end == str + 4 || *end != '\0' || !(mean >= 0)) return false;
+        dist->kind = DIST_EXP;
+        dist->mean_us = (uint64_t)(mean * 1000);
+        return true;
+    }
+    if (strncmp(str, "uniforme:", 9) == 0) str += 9;
+    double lo = strtod(str, &end);
+    if (end == str || *end != ':') return false;
+    const char* hi_str = end + 1;
+    double hi = strtod(hi_str, &end);
+    if (end == hi_str || *end != '\0' || !(lo >= 0) || hi < lo) return false;
+    dist->kind = DIST_UNIFORM;
+    dist->min_us = (uint64_t)(lo * 1000);
+    dist->max_us = (uint64_t)(hi * 1000);
+    return true;
+}
+
+/*
+ * Lê o cenário inteiro. Uma fase por linha, '#' comenta até o fim:
+ *   fase <nome> estudantes=N [refeicoes=K] [chegada=DIST] [refeicao=DIST] [lugares=L]
+ * chegada = intervalo entre refeições (get_food), refeicao = dine; o
+ * que faltar vem da carga padrão (e do -c). Retorna o número de fases,
+ * ou -1 depois de dizer em stderr onde está o erro.
+ */
+static int scenario_load(const char* path, Phase* phases, int max_phases) {
+    FILE* in = fopen(path, "r");
+    if (in == NULL) {
+        fprintf(stderr, "Erro: não consegui abrir o cenário '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    int count = 0, line_no = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), in)) {
+        line_no++;
+        char* hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char* save = NULL;
+        char* word = strtok_r(line, " \t\r\n", &save);
+        if (word == NULL) continue;
+
+        const char* error = NULL;
+        char* name = strtok_r(NULL, " \t\r\n", &save);
+        if (strcmp(word, "fase") != 0) error = "esperava 'fase <nome> ...'";
+        else if (name == NULL) error = "fase sem nome";
+        else if (count == max_phases) error = "fases demais";
+
+        Phase* ph = &phases[count];
+        if (error == NULL) {
+            memset(ph, 0, sizeof(*ph));
+            snprintf(ph->name, sizeof(ph->name), "%s", name);
+            ph->seats = -1;
+            ph->load = default_load;
+        }
+        while (error == NULL && (word = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+            char* value = strchr(word, '=');
+            if (value == NULL) {
+                error = "esperava chave=valor";
+                break;
+            }
+            *value++ = '\0';
+            char* end;
+            long n = strtol(value, &end, 10);
+            bool integer = end != value && *end == '\0';
+            if (strcmp(word, "estudantes") == 0) {
+                if (!integer || n < 2) error = "estudantes: pelo menos 2";
+                else ph->num_students = (int)n;
+            } else if (strcmp(word, "refeicoes") == 0) {
+                if (!integer || n < 1) error = "refeicoes: pelo menos 1";
+                else ph->load.iterations = (int)n;
+            } else if (strcmp(word, "lugares") == 0) {
+                if (!integer || n < 0 || n == 1) error = "lugares: 0 (sem limite) ou pelo menos 2";
+                else ph->seats = (int)n;
+            } else if (strcmp(word, "chegada") == 0) {
+                if (!parse_dist(value, &ph->load.get_food)) error = "chegada: min:max ou exp:media (ms)";
+            } else if (strcmp(word, "refeicao") == 0) {
+                if (!parse_dist(value, &ph->load.dine)) error = "refeicao: min:max ou exp:media (ms)";
+            } else {
+                error = "chave desconhecida";
+            }
+        }
+        if (error == NULL && ph->num_students == 0) error = "fase sem 'estudantes='";
+
+        if (error) {
+            fprintf(stderr, "Erro: %s:%d: %s\n", path, line_no, error);
+            fclose(in);
+            return -1;
+        }
+        count++;
+    }
+    fclose(in);
+
+    if (count == 0) fprintf(stderr, "Erro: o cenário '%s' não tem fases.\n", path);
+    return count > 0 ? count : -1;
+}
+
+/* Menor balde do histograma de latência que cobre a fração `q` */
+static uint64_t hist_quantile_us(const unsigned long* hist, double q) {
+    uint64_t total = 0, seen = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++) total += hist[b];
+    uint64_t want = (uint64_t)(q * total + 0.999999);
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen >= want) return b == 0 ? 1 : 1ull << b;
+    }
+    return 1ull << (HIST_BUCKETS - 1);
+}
+
+/*
+ * Roda as fases em sequência, cada uma num refeitório novo. Tudo que não
+ * é carga (criar o refeitório e as threads) fica antes da largada; o
+ * tempo de cada fase vai da largada ao último estudante (latch).
+ * Retorna 0, 1 se um refeitório não pôde ser criado, 3 se houve violação.
+ */
+int scenario_main(const char* engine, const Phase* phases, int num_phases, int seats,
+                  int placement, const char* sleep_mode) {
+    int max_students = 0;
+    for (int p = 0; p < num_phases; p++) {
+        if (phases[p].num_students > max_students) max_students = phases[p].num_students;
+    }
+    StudentArgs* args = malloc(sizeof(StudentArgs) * max_students);
+
+    dh_topology_t topo = { 0 };
+    if (placement != DH_PLACE_NONE && dh_topology_load(&topo) != 0) {
+        fprintf(stderr, "Aviso: topologia indisponível (%s); -a ignorado.\n", strerror(errno));
+    }
+
+    int status = 0;
+    long day_meals = 0;
+    uint64_t day_ns = 0;
+    unsigned long violations = 0;
+    for (int p = 0; p < num_phases; p++) {
+        const Phase* ph = &phases[p];
+        int n = ph->num_students;
+        dh_hall_t* hall = dh_create_engine(engine, n);
+        if (hall == NULL) {
+            fprintf(stderr, "Erro: motor desconhecido '%s'.\n", engine ? engine : "(padrão)");
+            status = 1;
+            break;
+        }
+        int phase_seats = ph->seats >= 0 ? ph->seats : seats;
+        dh_set_capacity(hall, phase_seats);
+
+        unsigned long before[HIST_BUCKETS];
+        for (int b = 0; b < HIST_BUCKETS; b++) {
+            before[b] = atomic_load_explicit(&latency_hist[HIST_ENTER][b], memory_order_relaxed);
+        }
+
+        memset(args, 0, sizeof(StudentArgs) * n);
+        Gate gate;
+        Latch latch;
+        gate_init(&gate);
+        latch_init(&latch, n);
+        uint64_t created = wall_now_ns();
+        for (int i = 0; i < n; i++) {
+            args[i].id = i + 1;
+            args[i].hall = hall;
+            args[i].load = &ph->load;
+            args[i].latch = &latch;
+            args[i].cpu = dh_place_cpu(&topo, placement, i, 1);
+            atomic_init(&args[i].live.phase, LIVE_STARTING);
+            atomic_init(&args[i].live.since_ns, created);
+        }
+        uint64_t start_ns = start_students(args, n, &gate);
+        latch_wait(&latch, 0);
+        uint64_t load_ns = atomic_load_explicit(&latch.end_ns, memory_order_relaxed) - start_ns;
+
+        long meals = 0;
+        for (int i = 0; i < n; i++) meals += args[i].meals;
+        unsigned long enter[HIST_BUCKETS];
+        for (int b = 0; b < HIST_BUCKETS; b++) {
+            enter[b] = atomic_load_explicit(&latency_hist[HIST_ENTER][b], memory_order_relaxed) -
+                       before[b];
+        }
+
+        printf("fase %-12s %4d estudantes  lugares %-3d %5ld/%-5ld refeições %8.3f s "
+               "%9.1f refeições/s  enter p50 < %llu µs, p99 < %llu µs\n",
+               ph->name, n, phase_seats, meals, (long)n * ph->load.iterations, load_ns / 1e9,
+               load_ns > 0 ? meals / (load_ns / 1e9) : 0.0,
+               (unsigned long long)hist_quantile_us(enter, 0.50),
+               (unsigned long long)hist_quantile_us(enter, 0.99));
+        if (sleep_mode) print_sleep_report(args, n, sleep_mode);
+
+        violations += dh_check_violations(hall);
+        dh_destroy(hall);
+        day_meals += meals;
+        day_ns += load_ns;
+    }
+    dh_topology_free(&topo);
+
+    if (status == 0) {
+        printf("--- Dia: %d fases, %ld refeições em %.3f s de carga ---\n", num_phases,
+               day_meals, day_ns / 1e9);
+    }
+    if (violations > 0) {
+        fprintf(stderr, "Invariantes do monitor violados %lu vez(es).\n", violations);
+        status = 3;
+    }
+    free(args);
+    return status;
+}
+
+void usage(const char* prog) {
+    fprintf(stderr, "Uso: %s [-e motor] [-m ms] [-p] [-w] [-s rel|abs|spin_us] [-t] [-a política] "
+            "[-c lugares] [-d arquivo] "
+            "[-r|-R arquivo] [-F semente [-k rodadas]] <numero_estudantes>\n"
+            "     %s [-e motor] [-s rel|abs|spin_us] [-a política] [-c lugares] -S cenário\n",
+            prog, prog);
+    fprintf(stderr, "Motores:\n");
+    const char* description;
+    for (int i = 0; dh_engine_at(i, &description) != NULL; i++) {
+        fprintf(stderr, "  %-8s %s\n", dh_engine_at(i, NULL), description);
+    }
+}
+
 int main(int argc, char* argv[]) {
     srand(time(NULL));
 
-    if (argc != 2) {
-        fprintf(stderr, "Uso: %s <numero_estudantes>\n", argv[0]);
+    const char* engine = getenv("DH_ENGINE"); // -e tem precedência
+    int observe_ms = 0;
+    bool profile = false;
+    bool waits = false;
+    const char* dump_path = NULL;
+    const char* record_path = NULL;
+    const char* replay_path = NULL;
+    const char* fuzz_seed = NULL;
+    long fuzz_rounds = 1000;
+    const char* sleep_mode = NULL;
+    bool timings = false;
+    int placement = DH_PLACE_NONE;
+    int seats = 0;
+    bool seats_given = false;
+    const char* scenario_path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "e:m:pws:ta:c:d:r:R:F:k:S:")) != -1) {
+        switch (opt) {
+        case 'e': engine = optarg; break;
+        case 'm': observe_ms = atoi(optarg); break;
+        case 'p': profile = true; break;
+        case 'w': waits = true; break;
+        case 's': sleep_mode = optarg; break;
+        case 't': timings = true; break;
+        case 'a':
+            placement = dh_place_parse(optarg);
+            if (placement < 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'c': seats = atoi(optarg); seats_given = true; break;
+        case 'd': dump_path = optarg; break;
+        case 'r': record_path = optarg; break;
+        case 'R': replay_path = optarg; break;
+        case 'F': fuzz_seed = optarg; break;
+        case 'k': fuzz_rounds = atol(optarg); break;
+        case 'S': scenario_path = optarg; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (argc - optind != (scenario_path ? 0 : 1)) {
+        usage(argv[0]);
         return 1;
     }
 
-    const int num_students = atoi(argv[1]);
-    if (num_students < 2) {
+    if (seats < 0 || seats == 1) {
+        fprintf(stderr, "Erro: o refeitório precisa de pelo menos 2 lugares (ou 0 = sem limite).\n");
+        return 1;
+    }
+
+    default_load.iterations = NUM_ITERATIONS;
+    default_load.get_food = (SleepDist){ .kind = DIST_UNIFORM, .min_us = MIN_SLEEP_MS * 1000ull,
+                                         .max_us = MAX_SLEEP_MS * 1000ull };
+    default_load.dine = default_load.get_food;
+
+    // Cenário lido e validado inteiro aqui, antes de qualquer medição
+    static Phase phases[MAX_PHASES];
+    int num_phases = 0;
+    if (scenario_path) {
+        if (fuzz_seed || record_path || replay_path || profile || waits || observe_ms > 0 ||
+            dump_path || timings) {
+            fprintf(stderr, "Erro: -S não combina com -F/-r/-R/-p/-w/-m/-d/-t.\n");
+            return 1;
+        }
+        num_phases = scenario_load(scenario_path, phases, MAX_PHASES);
+        if (num_phases < 0) return 1;
+    }
+
+    const int num_students = scenario_path ? 0 : atoi(argv[optind]);
+    if (!scenario_path && num_students < 2) {
         fprintf(stderr, "Erro: Minimo 2 estudantes.\n");
         return 1;
     }
 
-    pthread_t* students = malloc(sizeof(pthread_t) * num_students);
-    init_monitor(num_students); // Passamos o total para o monitor
+    if (sleep_mode) {
+        // Folga de 1ns: 0 em PR_SET_TIMERSLACK voltaria ao padrão (50µs)
+        if (strcmp(sleep_mode, "rel") == 0) {
+            dh_sleep_configure(DH_SLEEP_RELATIVE, 0, 0);
+        } else if (strcmp(sleep_mode, "abs") == 0) {
+            dh_sleep_configure(DH_SLEEP_PRECISE, 1, 0);
+        } else {
+            char* end;
+            long spin_us = strtol(sleep_mode, &end, 10);
+            if (*end != '\0' || spin_us < 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            dh_sleep_configure(DH_SLEEP_PRECISE, 1, spin_us * 1000);
+        }
+    }
+
+    if (scenario_path) {
+        return scenario_main(engine, phases, num_phases, seats, placement, sleep_mode);
+    }
+
+    if (fuzz_seed) {
+        if (record_path || replay_path || profile || waits || observe_ms > 0) {
+            fprintf(stderr, "Erro: -F não combina com -r/-R/-p/-w/-m.\n");
+            return 1;
+        }
+        return fuzz_main(engine, num_students, seats, strtoull(fuzz_seed, NULL, 0), fuzz_rounds);
+    }
+
+    // Reprodução: o arquivo diz o motor, quantos estudantes e os lugares
+    dh_sched_info_t replay_info;
+    if (replay_path) {
+        if (dh_sched_replay(replay_path, &replay_info) != 0) {
+            fprintf(stderr, "Erro: não consegui ler o escalonamento '%s': %s\n",
+                    replay_path, strerror(errno));
+            return 1;
+        }
+        if (replay_info.num_students != num_students) {
+            fprintf(stderr, "Erro: '%s' foi gravado com %d estudantes.\n",
+                    replay_path, replay_info.num_students);
+            return 1;
+        }
+        if (seats_given && seats != replay_info.seats) {
+            fprintf(stderr, "Erro: '%s' foi gravado com -c %d.\n", replay_path, replay_info.seats);
+            return 1;
+        }
+        seats = replay_info.seats;
+        if (engine == NULL) engine = replay_info.engine;
+    }
+
+    dh_hall_t* hall = dh_create_engine(engine, num_students); // Passamos o total para o monitor
+    if (hall == NULL) {
+        fprintf(stderr, "Erro: motor desconhecido '%s'.\n", engine ? engine : "(padrão)");
+        usage(argv[0]);
+        return 1;
+    }
+
+    dh_set_capacity(hall, seats);
+
+    if ((record_path || replay_path) && strcmp(dh_engine_name(hall), "mutex") != 0) {
+        fprintf(stderr, "Erro: -r/-R só funcionam com o motor mutex.\n");
+        return 1;
+    }
+    if (record_path && dh_sched_record(record_path, dh_engine_name(hall), num_students, seats) != 0) {
+        fprintf(stderr, "Erro: não consegui gravar em '%s': %s\n", record_path, strerror(errno));
+        return 1;
+    }
+
+    StudentArgs* args = calloc(num_students, sizeof(StudentArgs));
+    Gate gate;
+    Latch latch;
+    gate_init(&gate);
+    latch_init(&latch, num_students);
+
+    dh_topology_t topo = { 0 };
+    if (placement != DH_PLACE_NONE && dh_topology_load(&topo) != 0) {
+        fprintf(stderr, "Aviso: topologia indisponível (%s); -a ignorado.\n", strerror(errno));
+    }
 
     // printf("--- Iniciando com %d estudantes ---\n", num_students);
 
-    for (int i = 0; i < num_students; i++) {
-        int* id = malloc(sizeof(int));
-        *id = i + 1;
-        pthread_create(&students[i], NULL, student_routine, id);
+    if (waits) dh_waitstats_enable(true); // Antes de criar as threads
+
+    Reporter rep = { .hall = hall, .args = args, .num_students = num_students,
+                     .out = stderr, .start_ns = wall_now_ns() };
+    if (dump_path) {
+        rep.out = fopen(dump_path, "a");
+        if (rep.out == NULL) {
+            fprintf(stderr, "Erro: não consegui abrir '%s': %s\n", dump_path, strerror(errno));
+            return 1;
+        }
     }
+    pthread_t observer;
+    ObserverArgs obs = { .hall = hall, .interval_ms = observe_ms, .stop = false };
+    if (observe_ms > 0) pthread_create(&observer, NULL, observer_routine, &obs);
 
     for (int i = 0; i < num_students; i++) {
-        pthread_join(students[i], NULL);
+        args[i].id = i + 1;
+        args[i].hall = hall;
+        args[i].load = &default_load;
+        args[i].profile = profile;
+        args[i].waits_on = waits;
+        atomic_init(&args[i].live.phase, LIVE_STARTING);
+        atomic_init(&args[i].live.iteration, 0);
+        atomic_init(&args[i].live.since_ns, rep.start_ns);
+        args[i].latch = &latch;
+        args[i].cpu = dh_place_cpu(&topo, placement, i, 1);
     }
+    // Só com os args prontos: o dump lê todos eles
+    pthread_t reporter;
+    bool dumping = dump_start(&rep, &reporter);
+    uint64_t start_ns = start_students(args, num_students, &gate);
+    dh_topology_free(&topo);
+
+    latch_wait(&latch, 0);
+    uint64_t woke_ns = wall_now_ns();
+    uint64_t end_ns = atomic_load_explicit(&latch.end_ns, memory_order_relaxed);
+
+    if (observe_ms > 0) {
+        obs.stop = true;
+        pthread_join(observer, NULL);
+    }
+
+    if (record_path || replay_path) {
+        dh_sched_info_t recorded, replayed;
+        dh_sched_stop(&recorded, &replayed);
+        if (record_path) {
+            fprintf(stderr, "Escalonamento gravado em %s: %llu eventos%s\n", record_path,
+                    (unsigned long long)recorded.events,
+                    recorded.truncated ? " (CORTADO: capacidade esgotada)" : "");
+        }
+        if (replay_path) {
+            fprintf(stderr, "Reprodução de %s: %llu/%llu turnos seguidos%s\n", replay_path,
+                    (unsigned long long)replayed.replayed, (unsigned long long)replayed.turns,
+                    replayed.replayed < replayed.turns ? " (divergiu)" :
+                    replayed.truncated || !replayed.complete ?
+                    " (gravação interrompida; resto livre)" : "");
+        }
+    }
+
+    if (dumping) dump_stop(reporter);
+    if (dump_path) fclose(rep.out);
+
+    if (profile) print_phase_report(args, num_students);
+    if (waits) print_wait_report(args, num_students);
+    if (sleep_mode) print_sleep_report(args, num_students, sleep_mode);
 
     // printf("--- Fim da Simulação ---\n");
-    
-    destroy_monitor();
-    free(students);
-    return 0;
+
+    // Cada violação já foi avisada na hora (DH_CHECK=log) ou abortou (abort)
+    unsigned long violations = dh_check_violations(hall);
+    if (violations > 0) {
+        fprintf(stderr, "Invariantes do monitor violados %lu vez(es).\n", violations);
+    }
+
+    dh_destroy(hall);
+    free(args);
+
+    if (timings) {
+        // Criação: do início até a largada (threads paradas no portão).
+        // Carga: da largada até o último estudante terminar. Encerramento:
+        // dali até aqui (acordar a main, relatórios e liberar o refeitório).
+        uint64_t now = wall_now_ns();
+        printf("--- Tempos: criação %.3f ms (%d threads); carga %.3f s; main acordou "
+               "%.1f µs depois; encerramento %.3f ms ---\n", ms(start_ns - rep.start_ns),
+               num_students, (end_ns - start_ns) / 1e9, (woke_ns - end_ns) / 1e3,
+               ms(now - end_ns));
+    }
+    return violations > 0 ? 3 : 0;
 }
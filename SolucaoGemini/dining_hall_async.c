@@ -0,0 +1,270 @@
+/*
+ * dining_hall_async.c
+ * Driver da simulação em UMA thread com event loop (epoll), usando a API
+ * não bloqueante da libdininghall. Cada estudante é uma máquina de
+ * estados; as esperas do monitor viram dh_waiter_t e os "sleeps" viram
+ * timers numa heap. Assim uma única thread conduz milhares de estudantes.
+ *
+ * Uso: ./dining_hall_async <numero_estudantes> [iteracoes]
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "dininghall.h"
+
+/* Constantes */
+const int DEFAULT_ITERATIONS = 20;
+const int MIN_SLEEP_MS = 10;
+const int MAX_SLEEP_MS = 50;
+
+/* Fases de cada estudante */
+typedef enum {
+    PHASE_GET_FOOD,     // Timer rodando: pegando comida
+    PHASE_ENTERING,     // Esperando admissão (dh_enter_async pendente)
+    PHASE_DINING,       // Timer rodando: comendo
+    PHASE_LEAVING,      // Esperando o par na barreira (dh_leave_async pendente)
+    PHASE_DONE
+} StudentPhase;
+
+typedef struct EventLoop EventLoop;
+
+typedef struct Student {
+    int id;
+    EventLoop* loop;
+    int iteration;
+    StudentPhase phase;
+    dh_waiter_t waiter;         // Registro intrusivo reaproveitado a cada espera
+    struct Student* next_ready; // Fila de estudantes com espera concluída
+} Student;
+
+/* Timer: prazo absoluto (ns) + estudante dono */
+typedef struct {
+    uint64_t deadline;
+    Student* student;
+} Timer;
+
+/* Estado do event loop (tudo local à thread do loop) */
+struct EventLoop {
+    dh_hall_t* hall;
+    int num_iterations;
+    int active;                 // Estudantes que ainda não terminaram
+
+    Timer* heap;                // Min-heap de timers por prazo
+    int heap_size;
+
+    Student* ready_head;        // Esperas concluídas a processar
+    Student* ready_tail;
+
+    int event_fd;               // Acorda o epoll quando uma espera conclui
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* --- Heap de timers --- */
+
+static void heap_push(EventLoop* loop, uint64_t deadline, Student* s) {
+    int i = loop->heap_size++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (loop->heap[parent].deadline <= deadline) break;
+        loop->heap[i] = loop->heap[parent];
+        i = parent;
+    }
+    loop->heap[i].deadline = deadline;
+    loop->heap[i].student = s;
+}
+
+static Timer heap_pop(EventLoop* loop) {
+    Timer top = loop->heap[0];
+    Timer last = loop->heap[--loop->heap_size];
+    int i = 0;
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= loop->heap_size) break;
+        if (child + 1 < loop->heap_size &&
+            loop->heap[child + 1].deadline < loop->heap[child].deadline) {
+            child++;
+        }
+        if (last.deadline <= loop->heap[child].deadline) break;
+        loop->heap[i] = loop->heap[child];
+        i = child;
+    }
+    if (loop->heap_size > 0) loop->heap[i] = last;
+    return top;
+}
+
+static void random_sleep(EventLoop* loop, Student* s) {
+    int ms = MIN_SLEEP_MS + rand() % (MAX_SLEEP_MS - MIN_SLEEP_MS + 1);
+    heap_push(loop, now_ns() + (uint64_t)ms * 1000000ull, s);
+}
+
+/* --- Máquina de estados --- */
+
+static void make_ready(EventLoop* loop, Student* s) {
+    s->next_ready = NULL;
+    if (loop->ready_tail) loop->ready_tail->next_ready = s;
+    else loop->ready_head = s;
+    loop->ready_tail = s;
+}
+
+/*
+ * Callback da libdininghall: só enfileira; o loop processa depois.
+ * Aqui todas as chamadas ao refeitório saem da thread do loop, então o
+ * callback roda nela mesma e a fila dispensa lock. O eventfd acorda o
+ * epoll_wait caso a conclusão venha de outra thread que use o mesmo hall.
+ */
+static void on_waiter_done(dh_waiter_t* w, dh_status_t status) {
+    (void)status;
+    Student* s = w->user_data;
+    make_ready(s->loop, s);
+}
+
+static void student_finish(EventLoop* loop, Student* s) {
+    s->phase = PHASE_DONE;
+    loop->active--;
+    dh_done(loop->hall, s->id);
+}
+
+static void student_start_iteration(EventLoop* loop, Student* s) {
+    if (s->iteration >= loop->num_iterations) {
+        student_finish(loop, s);
+        return;
+    }
+    s->phase = PHASE_GET_FOOD;
+    random_sleep(loop, s);
+}
+
+static void student_entered(EventLoop* loop, Student* s, dh_status_t status) {
+    if (status == DH_ABORTED) {
+        student_finish(loop, s);
+        return;
+    }
+    s->phase = PHASE_DINING;
+    random_sleep(loop, s);
+}
+
+static void student_left(EventLoop* loop, Student* s) {
+    s->iteration++;
+    student_start_iteration(loop, s);
+}
+
+/* Timer de um estudante venceu */
+static void student_timer(EventLoop* loop, Student* s) {
+    dh_status_t status;
+    switch (s->phase) {
+    case PHASE_GET_FOOD:
+        s->phase = PHASE_ENTERING;
+        status = dh_enter_async(loop->hall, &s->waiter);
+        if (status != DH_PENDING) student_entered(loop, s, status);
+        break;
+    case PHASE_DINING:
+        s->phase = PHASE_LEAVING;
+        status = dh_leave_async(loop->hall, &s->waiter);
+        if (status != DH_PENDING) student_left(loop, s);
+        break;
+    default:
+        break;
+    }
+}
+
+/* Espera assíncrona de um estudante concluiu */
+static void student_ready(EventLoop* loop, Student* s) {
+    if (s->phase == PHASE_ENTERING) student_entered(loop, s, s->waiter.status);
+    else if (s->phase == PHASE_LEAVING) student_left(loop, s);
+}
+
+int main(int argc, char* argv[]) {
+    srand(time(NULL));
+
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Uso: %s <numero_estudantes> [iteracoes]\n", argv[0]);
+        return 1;
+    }
+
+    const int num_students = atoi(argv[1]);
+    if (num_students < 2) {
+        fprintf(stderr, "Erro: Minimo 2 estudantes.\n");
+        return 1;
+    }
+
+    EventLoop loop = {
+        .hall = dh_create_engine("mutex", num_students), // Único motor com API assíncrona
+        .num_iterations = argc == 3 ? atoi(argv[2]) : DEFAULT_ITERATIONS,
+        .active = num_students,
+        .heap = malloc(sizeof(Timer) * num_students),
+        .event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC),
+    };
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop.hall == NULL || loop.event_fd < 0 || epoll_fd < 0) {
+        perror("Erro ao preparar o event loop");
+        return 1;
+    }
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.fd = loop.event_fd };
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, loop.event_fd, &ev);
+
+    Student* students = calloc(num_students, sizeof(Student));
+    for (int i = 0; i < num_students; i++) {
+        Student* s = &students[i];
+        s->id = i + 1;
+        s->loop = &loop;
+        s->waiter.id = s->id;
+        s->waiter.callback = on_waiter_done;
+        s->waiter.user_data = s;
+        s->waiter.event_fd = loop.event_fd;
+        student_start_iteration(&loop, s);
+    }
+
+    uint64_t start = now_ns();
+    while (loop.active > 0) {
+        // Timers vencidos
+        uint64_t now = now_ns();
+        while (loop.heap_size > 0 && loop.heap[0].deadline <= now) {
+            Timer t = heap_pop(&loop);
+            student_timer(&loop, t.student);
+        }
+
+        // Esperas concluídas (drena o eventfd e processa a fila de prontos)
+        uint64_t count;
+        while (read(loop.event_fd, &count, sizeof(count)) > 0) {}
+        while (loop.ready_head) {
+            Student* s = loop.ready_head;
+            loop.ready_head = s->next_ready;
+            if (loop.ready_head == NULL) loop.ready_tail = NULL;
+            student_ready(&loop, s);
+        }
+
+        if (loop.active == 0) break;
+
+        int timeout_ms = -1;
+        if (loop.heap_size > 0) {
+            uint64_t next = loop.heap[0].deadline;
+            now = now_ns();
+            timeout_ms = next > now ? (int)((next - now + 999999) / 1000000) : 0;
+        }
+        struct epoll_event out;
+        epoll_wait(epoll_fd, &out, 1, timeout_ms);
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+
+    printf("--- %d estudantes em 1 thread: %.3fs ---\n", num_students, elapsed);
+
+    close(epoll_fd);
+    close(loop.event_fd);
+    dh_destroy(loop.hall);
+    free(students);
+    free(loop.heap);
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ * dining_hall_coro.cpp
+ * Driver da simulação com corrotinas C++20: cada estudante é uma corrotina
+ * equivalente ao student_routine do dining_hall.c, e todas rodam numa
+ * única thread (QueueExecutor + timers). Padrão: 100 mil estudantes.
+ *
+ * Uso: ./dining_hall_coro [numero_estudantes] [iteracoes]
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "dininghall_coro.hpp"
+
+/* Constantes */
+const int DEFAULT_STUDENTS = 100000;
+const int DEFAULT_ITERATIONS = 20;
+const int MIN_SLEEP_MS = 10;
+const int MAX_SLEEP_MS = 50;
+
+using Clock = std::chrono::steady_clock;
+
+/* Event loop de uma thread: executor de corrotinas + timers */
+class RunLoop {
+public:
+    explicit RunLoop(std::size_t max_timers) { timers_.reserve(max_timers); }
+
+    dh::Executor& executor() { return ready_; }
+
+    /* co_await loop.sleep_for(ms): o nó do timer vive no frame da corrotina */
+    class SleepAwaiter {
+    public:
+        SleepAwaiter(RunLoop& loop, Clock::time_point deadline)
+            : loop_(loop), deadline_(deadline) {}
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            node_.handle = handle;
+            loop_.add_timer(deadline_, &node_);
+        }
+        void await_resume() const noexcept {}
+
+    private:
+        RunLoop& loop_;
+        Clock::time_point deadline_;
+        dh::Resumable node_;
+    };
+
+    SleepAwaiter sleep_for(int ms) {
+        return SleepAwaiter(*this, Clock::now() + std::chrono::milliseconds(ms));
+    }
+
+    /* Roda até não haver mais nada pronto nem timers pendentes */
+    void run() {
+        while (true) {
+            ready_.run_ready();
+            if (timers_.empty()) break;
+
+            std::this_thread::sleep_until(timers_.front().deadline);
+
+            auto now = Clock::now();
+            while (!timers_.empty() && timers_.front().deadline <= now) {
+                std::pop_heap(timers_.begin(), timers_.end(), later);
+                ready_.schedule(timers_.back().task);
+                timers_.pop_back();
+            }
+        }
+    }
+
+private:
+    struct Timer {
+        Clock::time_point deadline;
+        dh::Resumable* task;
+    };
+
+    static bool later(const Timer& a, const Timer& b) { return a.deadline > b.deadline; }
+
+    void add_timer(Clock::time_point deadline, dh::Resumable* task) {
+        timers_.push_back({deadline, task});
+        std::push_heap(timers_.begin(), timers_.end(), later);
+    }
+
+    dh::QueueExecutor ready_;
+    std::vector<Timer> timers_;   // Min-heap; reservado para 1 timer por estudante
+};
+
+/* Estado compartilhado da simulação (só a thread do loop acessa) */
+struct Simulation {
+    RunLoop& loop;
+    dh::Hall& hall;
+    int num_iterations;
+    std::minstd_rand rng;
+    long meals = 0;
+
+    int random_ms() {
+        return MIN_SLEEP_MS + static_cast<int>(rng() % (MAX_SLEEP_MS - MIN_SLEEP_MS + 1));
+    }
+};
+
+/* Equivalente ao student_routine, mas suspendendo em vez de bloquear */
+dh::Task student_routine(Simulation& sim, int id) {
+    for (int i = 0; i < sim.num_iterations; i++) {
+        co_await sim.loop.sleep_for(sim.random_ms());   // get_food
+
+        // Tenta entrar. Se retornar false, aborta o loop inteiro.
+        if (!co_await sim.hall.enter(id)) break;
+
+        co_await sim.loop.sleep_for(sim.random_ms());   // dine
+        co_await sim.hall.leave(id);
+        sim.meals++;
+    }
+
+    // Marca presença como finalizado antes de terminar
+    sim.hall.done(id);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 3) {
+        std::fprintf(stderr, "Uso: %s [numero_estudantes] [iteracoes]\n", argv[0]);
+        return 1;
+    }
+
+    const int num_students = argc >= 2 ? std::atoi(argv[1]) : DEFAULT_STUDENTS;
+    const int num_iterations = argc == 3 ? std::atoi(argv[2]) : DEFAULT_ITERATIONS;
+    if (num_students < 2) {
+        std::fprintf(stderr, "Erro: Minimo 2 estudantes.\n");
+        return 1;
+    }
+
+    RunLoop loop(num_students);
+    dh::Hall hall(num_students, loop.executor());
+    Simulation sim{loop, hall, num_iterations,
+                   std::minstd_rand(static_cast<unsigned>(std::time(nullptr)))};
+
+    auto start = Clock::now();
+    for (int i = 0; i < num_students; i++) {
+        student_routine(sim, i + 1);
+    }
+    loop.run();
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    std::printf("--- %d estudantes (corrotinas) em 1 thread: %ld refeicoes em %.3fs ---\n",
+                num_students, sim.meals, elapsed.count());
+    return 0;
+}
@@ -10,6 +10,7 @@
 #include <pthread.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <time.h>
 #include <sys/time.h> // Para gettimeofday (microsegundos)
 
@@ -31,12 +32,25 @@ typedef struct {
     pthread_cond_t ok_to_leave;
 } DiningMonitor;
 
+/*
+ * Cópia dos contadores para o logger (seqlock). Os escritores já estão
+ * serializados por monitor.lock; get_food/dine leem sem lock e sem
+ * valores rasgados. `seq` ímpar = escrita em andamento.
+ */
+typedef struct {
+    atomic_uint seq;
+    atomic_int eating_count;
+    atomic_int waiting_to_eat;
+} MonitorSnapshot;
+
 /* Globais */
 DiningMonitor monitor;
+MonitorSnapshot snapshot;
 FILE* log_file = NULL;
 pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER; // Mutex exclusivo para o arquivo
 
 /* Protótipos */
+void publish_snapshot(void);
 void log_event(int id, const char* action, const char* reason);
 void random_sleep(void);
 void get_food(int id);
@@ -46,18 +60,40 @@ void leave_hall(int id);
 void student_done(int id);
 
 /* --- Implementação do Logger --- */
+
+/* Chamar com monitor.lock, depois de mudar os contadores */
+void publish_snapshot(void) {
+    unsigned seq = atomic_load_explicit(&snapshot.seq, memory_order_relaxed);
+    atomic_store_explicit(&snapshot.seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&snapshot.eating_count, monitor.eating_count, memory_order_relaxed);
+    atomic_store_explicit(&snapshot.waiting_to_eat, monitor.waiting_to_eat, memory_order_relaxed);
+    atomic_store_explicit(&snapshot.seq, seq + 2, memory_order_release);
+}
+
 void log_event(int id, const char* action, const char* reason) {
     if (log_file == NULL) return;
 
     struct timeval tv;
     gettimeofday(&tv, NULL);
+
+    // Leitura do seqlock: repete se pegou uma escrita no meio
+    int eating, waiting;
+    unsigned before, after;
+    do {
+        before = atomic_load_explicit(&snapshot.seq, memory_order_acquire);
+        eating = atomic_load_explicit(&snapshot.eating_count, memory_order_relaxed);
+        waiting = atomic_load_explicit(&snapshot.waiting_to_eat, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&snapshot.seq, memory_order_relaxed);
+    } while ((before & 1) || before != after);
     
     pthread_mutex_lock(&log_lock);
     // Formato: [TIMESTAMP] [STUDENT_ID] ACTION | State | Reason
     fprintf(log_file, "[%ld.%06ld] [Estudante %02d] %-15s | Eat:%d Wait:%d | %s\n",
             tv.tv_sec, (long)tv.tv_usec, 
             id, action, 
-            monitor.eating_count, monitor.waiting_to_eat, 
+            eating, waiting,
             reason ? reason : "");
     fflush(log_file); // Garante escrita imediata no disco
     pthread_mutex_unlock(&log_lock);
@@ -86,6 +122,7 @@ bool enter_hall(int id) {
     
     log_event(id, "REQ_ENTRY", "Tentando sentar");
     monitor.waiting_to_eat++;
+    publish_snapshot();
 
     while (true) {
         bool can_sit = (monitor.eating_count > 0) || (monitor.waiting_to_eat >= 2);
@@ -95,6 +132,7 @@ bool enter_hall(int id) {
         int active_students = monitor.total_students - monitor.finished_students;
         if (monitor.eating_count == 0 && active_students < 2) {
             monitor.waiting_to_eat--;
+            publish_snapshot();
             log_event(id, "ABORT_ENTRY", "Último sobrevivente detectado");
             pthread_mutex_unlock(&monitor.lock);
             return false; 
@@ -106,7 +144,8 @@ bool enter_hall(int id) {
 
     monitor.waiting_to_eat--;
     monitor.eating_count++;
-    
+    publish_snapshot();
+
     log_event(id, "ENTERED", "Conseguiu mesa");
 
     pthread_cond_signal(&monitor.ok_to_sit);
@@ -130,6 +169,7 @@ void leave_hall(int id) {
     }
 
     monitor.eating_count--;
+    publish_snapshot();
     log_event(id, "LEFT", "Saiu do refeitório");
 
     pthread_cond_broadcast(&monitor.ok_to_leave);
@@ -0,0 +1,199 @@
+/*
+ * dininghall.c
+ * Fachada da libdininghall: registro dos motores de sincronização e
+ * despacho da API pública pela vtable de cada refeitório.
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "dh_engine.h"
+
+/* Motores registrados; o primeiro é o padrão */
+static const dh_engine_ops* const ENGINES[] = {
+    &dh_engine_mutex,
+    &dh_engine_sem,
+    &dh_engine_futex,
+    &dh_engine_mcs,
+    &dh_engine_clh,
+    &dh_engine_cohort,
+    &dh_engine_spin,
+    &dh_engine_fc,
+    &dh_engine_rcl,
+};
+
+static const int NUM_ENGINES = sizeof(ENGINES) / sizeof(ENGINES[0]);
+
+static const dh_engine_ops* find_engine(const char* name) {
+    for (int i = 0; i < NUM_ENGINES; i++) {
+        if (strcmp(ENGINES[i]->name, name) == 0) return ENGINES[i];
+    }
+    return NULL;
+}
+
+const char* dh_engine_at(int index, const char** description) {
+    if (index < 0 || index >= NUM_ENGINES) return NULL;
+    if (description) *description = ENGINES[index]->description;
+    return ENGINES[index]->name;
+}
+
+/* $DH_CHECK = off | log | abort (qualquer outra coisa: log) */
+static dh_check_mode_t default_check_mode(void) {
+    const char* mode = getenv("DH_CHECK");
+    if (mode == NULL) return DH_CHECK_LOG;
+    if (strcmp(mode, "off") == 0) return DH_CHECK_OFF;
+    if (strcmp(mode, "abort") == 0) return DH_CHECK_ABORT;
+    return DH_CHECK_LOG;
+}
+
+dh_hall_t* dh_create_engine(const char* engine, int total_students) {
+    if (total_students < 2) return NULL;
+
+    const dh_engine_ops* ops = engine ? find_engine(engine) : ENGINES[0];
+    if (ops == NULL) return NULL;
+
+    dh_hall_t* hall = ops->create(total_students);
+    if (hall) hall->check_mode = default_check_mode();
+    return hall;
+}
+
+dh_hall_t* dh_create(int total_students) {
+    // Permite trocar o motor por implantação, sem recompilar
+    return dh_create_engine(getenv("DH_ENGINE"), total_students);
+}
+
+void dh_destroy(dh_hall_t* hall) {
+    if (hall == NULL) return;
+    hall->ops->destroy(hall);
+}
+
+const char* dh_engine_name(const dh_hall_t* hall) {
+    return hall->ops->name;
+}
+
+void dh_snapshot(const dh_hall_t* hall, dh_stats_t* out) {
+    // dh_publish só escreve pelo ponteiro não-const; aqui só lemos
+    dh_published_t* p = (dh_published_t*)&hall->published;
+    unsigned before, after;
+    do {
+        before = atomic_load_explicit(&p->seq, memory_order_acquire);
+        if (before & 1) {
+            after = before + 1; // Escrita em andamento: tenta de novo
+            continue;
+        }
+        out->eating_count = atomic_load_explicit(&p->eating_count, memory_order_relaxed);
+        out->waiting_to_eat = atomic_load_explicit(&p->waiting_to_eat, memory_order_relaxed);
+        out->waiting_to_leave = atomic_load_explicit(&p->waiting_to_leave, memory_order_relaxed);
+        out->finished_students = atomic_load_explicit(&p->finished_students, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&p->seq, memory_order_relaxed);
+    } while (before != after);
+
+    out->version = before;
+    out->total_students = hall->state.total_students; // Constante
+    out->capacity = hall->state.capacity;             // Fixa antes do uso
+}
+
+/* --- Invariantes --- */
+
+/* Avisos em stderr no modo log; depois disso só conta */
+#define CHECK_LOG_LIMIT 10
+
+__attribute__((cold, noinline))
+void dh_check_failed(dh_hall_t* hall) {
+    const dh_state_t* s = &hall->state;
+    int e = atomic_load_explicit(&s->eating_count, memory_order_relaxed);
+    unsigned long n = atomic_fetch_add_explicit(&hall->violations, 1, memory_order_relaxed) + 1;
+    DH_PROBE(invariant, -1, s);
+
+    if (hall->check_mode == DH_CHECK_OFF) return;
+    if (hall->check_mode == DH_CHECK_LOG && n > CHECK_LOG_LIMIT) return;
+
+    // Ainda com o lock: os valores são os da transição que violou
+    fprintf(stderr,
+            "libdininghall: invariante violado (%s, #%lu): eating=%d waiting_to_eat=%d "
+            "waiting_to_leave=%d finished=%d/%d\n",
+            hall->ops->name, n, e, s->waiting_to_eat, s->waiting_to_leave,
+            s->finished_students, s->total_students);
+    if (hall->check_mode == DH_CHECK_ABORT) abort();
+    if (n == CHECK_LOG_LIMIT) {
+        fprintf(stderr, "libdininghall: próximas violações só serão contadas\n");
+    }
+}
+
+int dh_set_capacity(dh_hall_t* hall, int seats) {
+    if (seats < 0 || seats == 1) return -1;
+    hall->state.capacity = seats; // Ninguém dentro ainda: sem corrida com os motores
+    return 0;
+}
+
+int dh_set_classes(dh_hall_t* hall, const int* weights, int num_classes) {
+    if (hall->ops->enter_class == NULL) return -1;
+    if (num_classes < 1 || num_classes > DH_MAX_CLASSES) return -1;
+    for (int c = 0; c < num_classes; c++) {
+        if (weights[c] < 1 || weights[c] > 1000) return -1;
+    }
+
+    dh_classes_t* classes = &hall->classes; // Ninguém dentro ainda, como em dh_set_capacity
+    memset(classes, 0, sizeof(*classes));
+    classes->num_classes = num_classes;
+    for (int c = 0; c < num_classes; c++) classes->stats[c].weight = weights[c];
+    return 0;
+}
+
+int dh_class_stats(const dh_hall_t* hall, int cls, dh_class_stats_t* out) {
+    if (cls < 0 || cls >= DH_MAX_CLASSES) return -1;
+    *out = hall->classes.stats[cls];
+    return 0;
+}
+
+void dh_set_check_mode(dh_hall_t* hall, dh_check_mode_t mode) {
+    hall->check_mode = mode;
+}
+
+unsigned long dh_check_violations(const dh_hall_t* hall) {
+    return atomic_load_explicit(&((dh_hall_t*)hall)->violations, memory_order_relaxed);
+}
+
+bool dh_enter(dh_hall_t* hall, int id) {
+    return hall->ops->enter(hall, id);
+}
+
+bool dh_enter_class(dh_hall_t* hall, int id, int cls) {
+    if (hall->ops->enter_class == NULL) return hall->ops->enter(hall, id);
+    if (cls < 0 || cls >= hall->classes.num_classes) cls = 0;
+    return hall->ops->enter_class(hall, id, cls);
+}
+
+void dh_leave(dh_hall_t* hall, int id) {
+    hall->ops->leave(hall, id);
+}
+
+void dh_done(dh_hall_t* hall, int id) {
+    hall->ops->done(hall, id);
+}
+
+/* --- API não bloqueante (só nos motores que a implementam) --- */
+
+dh_status_t dh_try_enter(dh_hall_t* hall, int id) {
+    if (hall->ops->try_enter == NULL) return DH_UNSUPPORTED;
+    return hall->ops->try_enter(hall, id);
+}
+
+dh_status_t dh_try_leave(dh_hall_t* hall, int id) {
+    if (hall->ops->try_leave == NULL) return DH_UNSUPPORTED;
+    return hall->ops->try_leave(hall, id);
+}
+
+dh_status_t dh_enter_async(dh_hall_t* hall, dh_waiter_t* waiter) {
+    if (hall->ops->enter_async == NULL) return DH_UNSUPPORTED;
+    return hall->ops->enter_async(hall, waiter);
+}
+
+dh_status_t dh_leave_async(dh_hall_t* hall, dh_waiter_t* waiter) {
+    if (hall->ops->leave_async == NULL) return DH_UNSUPPORTED;
+    return hall->ops->leave_async(hall, waiter);
+}
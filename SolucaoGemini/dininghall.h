@@ -0,0 +1,226 @@
+/*
+ * dininghall.h
+ * API pública da libdininghall: o protocolo de admissão do
+ * Extended Dining Hall Problem empacotado como biblioteca.
+ *
+ * Cada refeitório é uma instância independente (dh_hall_t*), sem
+ * nenhum estado global. Vários refeitórios podem coexistir no mesmo
+ * processo e ser usados por threads diferentes ao mesmo tempo.
+ *
+ * Uso típico (por estudante):
+ *     while (...) {
+ *         if (!dh_enter(hall, id)) break;  // false = sem parceiros possíveis
+ *         ...comer...
+ *         dh_leave(hall, id);
+ *     }
+ *     dh_done(hall, id);                   // obrigatório ao terminar
+ *
+ * Para event loops (epoll etc.) há uma API não bloqueante: dh_try_enter /
+ * dh_try_leave retornam na hora, e dh_enter_async / dh_leave_async
+ * registram um dh_waiter_t que é concluído (callback e/ou eventfd) quando
+ * a admissão ou a saída for liberada.
+ *
+ * O protocolo é implementado por vários "motores" de sincronização
+ * (mutex, semáforos, futex, spin...), escolhidos em tempo de execução por
+ * dh_create_engine() ou pela variável de ambiente DH_ENGINE.
+ *
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#ifndef DININGHALL_H
+#define DININGHALL_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Handle opaco para um refeitório */
+typedef struct dh_hall dh_hall_t;
+
+/* Resultado das operações não bloqueantes */
+typedef enum {
+    DH_OK = 0,       // Concluiu: sentou (enter) ou saiu (leave)
+    DH_ABORTED,      // enter: não há mais parceiros possíveis
+    DH_WOULDBLOCK,   // try_*: teria que esperar (nada foi registrado)
+    DH_PENDING,      // *_async: espera registrada, conclusão virá depois
+    DH_UNSUPPORTED   // O motor deste refeitório não tem API não bloqueante
+} dh_status_t;
+
+typedef struct dh_waiter dh_waiter_t;
+
+/* Retrato consistente dos contadores do monitor (ver dh_snapshot) */
+typedef struct {
+    unsigned version;          // Muda (de 2 em 2) a cada publicação
+    int eating_count;
+    int waiting_to_eat;
+    int waiting_to_leave;
+    int total_students;
+    int finished_students;
+    int capacity;              // Lugares (0 = sem limite)
+} dh_stats_t;
+
+/*
+ * Reação a uma violação dos invariantes do protocolo, conferidos a cada
+ * transição do monitor (ver dh_set_check_mode).
+ */
+typedef enum {
+    DH_CHECK_OFF = 0,          // Só conta (dh_check_violations)
+    DH_CHECK_LOG,              // Conta e avisa em stderr (as primeiras) - padrão
+    DH_CHECK_ABORT             // Avisa e chama abort() na hora
+} dh_check_mode_t;
+
+/* Chamado fora do lock do refeitório; pode chamar a API de novo. */
+typedef void (*dh_callback_t)(dh_waiter_t* waiter, dh_status_t status);
+
+/*
+ * Registro de espera assíncrona. Pertence ao chamador (intrusivo: a
+ * biblioteca não aloca nada por espera) e não pode ser liberado nem
+ * reutilizado enquanto estiver pendente.
+ * Na conclusão: `status` é preenchido, `callback` é chamado (se houver)
+ * e, por último, 1 é somado ao `event_fd` (se >= 0).
+ */
+struct dh_waiter {
+    int id;
+    dh_callback_t callback;
+    void* user_data;
+    int event_fd;
+    dh_status_t status;
+
+    dh_waiter_t* next;         // Privado: fila interna do refeitório
+};
+
+/*
+ * Cria um refeitório para `total_students` estudantes, com o motor dado
+ * por $DH_ENGINE (ou o padrão, "mutex", se a variável não existir).
+ * Retorna NULL se total_students < 2, se o motor não existir ou se
+ * faltar memória.
+ */
+dh_hall_t* dh_create(int total_students);
+
+/* Igual a dh_create, escolhendo o motor pelo nome (NULL = padrão). */
+dh_hall_t* dh_create_engine(const char* engine, int total_students);
+
+/*
+ * Lista os motores: nome do motor na posição `index` (NULL após o último).
+ * Se `description` não for NULL, recebe uma descrição curta.
+ */
+const char* dh_engine_at(int index, const char** description);
+
+/* Nome do motor usado por um refeitório. */
+const char* dh_engine_name(const dh_hall_t* hall);
+
+/*
+ * Lê os contadores sem lock (seqlock): nunca bloqueia nem atrasa os
+ * estudantes, e o retrato é sempre de um mesmo instante (sem valores
+ * "rasgados"). Pode ser chamado de qualquer thread (logger, watchdog).
+ * Não chamar de um tratador de sinal: se o sinal interromper uma
+ * publicação na mesma thread, o número de sequência fica ímpar e a
+ * leitura gira para sempre.
+ */
+void dh_snapshot(const dh_hall_t* hall, dh_stats_t* out);
+
+/*
+ * Invariantes conferidos em toda transição, dentro da seção crítica:
+ * nenhum contador negativo, ninguém comendo sozinho (eating_count == 1 só
+ * com alguém prestes a sentar ou o par saindo junto), waiting_to_leave <=
+ * eating_count, finished_students <= total_students e, com lugares
+ * limitados, eating_count <= capacidade. A conferência é um
+ * único desvio sobre valores que o monitor já tem em registradores; o
+ * tratamento da falha fica fora do caminho quente. O modo inicial vem de
+ * $DH_CHECK (off, log ou abort; padrão log).
+ */
+void dh_set_check_mode(dh_hall_t* hall, dh_check_mode_t mode);
+
+/* Quantas violações o refeitório já viu (em qualquer modo) */
+unsigned long dh_check_violations(const dh_hall_t* hall);
+
+/*
+ * Limita o refeitório a `seats` lugares (0 = sem limite, o padrão). As
+ * regras de companhia continuam valendo, então são pelo menos 2 lugares.
+ * Quem chega com o refeitório lotado espera e só é acordado quando um
+ * lugar vaga (um por lugar, não todos). Chamar antes de qualquer estudante
+ * usar o refeitório. Retorna 0, ou -1 se `seats` for 1 ou negativo.
+ */
+int dh_set_capacity(dh_hall_t* hall, int seats);
+
+/* --- Classes de prioridade (só no motor "mutex") --- */
+
+#define DH_MAX_CLASSES 4
+#define DH_CLASS_AGING 8       // Admissões de outras classes até uma classe furar a fila
+
+/* Contadores de uma classe (ver dh_class_stats) */
+typedef struct {
+    int weight;
+    unsigned long arrivals;    // Chamadas de entrada (inclui as que abortaram)
+    unsigned long admitted;    // Sentaram
+    unsigned long aborted;     // Desistiram (sem parceiros possíveis)
+    unsigned long aged;        // Sentaram por envelhecimento, à frente do peso
+    unsigned long paired[DH_MAX_CLASSES]; // Grupos abertos por esta classe, pela classe do 2º a sentar
+} dh_class_stats_t;
+
+/*
+ * Divide os estudantes em `num_classes` classes (ex.: 0 = funcionários,
+ * 1 = alunos). Quando lugares vagam (dh_set_capacity), a vez é repartida
+ * entre as classes que esperam na proporção dos pesos (fila justa
+ * ponderada); uma classe preterida por DH_CLASS_AGING admissões seguidas
+ * passa na frente, então peso baixo atrasa mas não deixa ninguém sem
+ * comer. As regras de companhia não mudam: a prioridade só escolhe QUEM
+ * senta quando alguém pode sentar. Sem limite de lugares todos que
+ * esperam sentam juntos e as classes só são contadas.
+ * Chamar antes de qualquer estudante usar o refeitório. Retorna 0, ou -1
+ * se os argumentos forem inválidos (pesos de 1 a 1000) ou se o motor não
+ * tiver classes.
+ */
+int dh_set_classes(dh_hall_t* hall, const int* weights, int num_classes);
+
+/* dh_enter para um estudante da classe `cls` (fora do intervalo = 0). */
+bool dh_enter_class(dh_hall_t* hall, int id, int cls);
+
+/*
+ * Copia os contadores da classe `cls`. Ler com os estudantes parados (os
+ * contadores são do monitor). Retorna 0, ou -1 se `cls` for inválida.
+ */
+int dh_class_stats(const dh_hall_t* hall, int cls, dh_class_stats_t* out);
+
+/* Libera o refeitório. Nenhuma thread pode estar dentro dele. */
+void dh_destroy(dh_hall_t* hall);
+
+/*
+ * Tenta entrar no refeitório (bloqueia até ter com quem comer).
+ * Retorna: true se conseguiu sentar.
+ * Retorna: false se deve abortar (não há mais parceiros).
+ */
+bool dh_enter(dh_hall_t* hall, int id);
+
+/* Sai do refeitório sem deixar ninguém comendo sozinho. */
+void dh_leave(dh_hall_t* hall, int id);
+
+/*
+ * Avisa que o estudante terminou TODAS as iterações.
+ * Importante para os que sobraram saberem que "não vem mais ninguém".
+ */
+void dh_done(dh_hall_t* hall, int id);
+
+/* --- API não bloqueante (só no motor "mutex"; os demais dão DH_UNSUPPORTED) --- */
+
+/* Entra se puder agora: DH_OK, DH_ABORTED ou DH_WOULDBLOCK. */
+dh_status_t dh_try_enter(dh_hall_t* hall, int id);
+
+/* Sai se não precisar esperar o par: DH_OK ou DH_WOULDBLOCK. */
+dh_status_t dh_try_leave(dh_hall_t* hall, int id);
+
+/*
+ * Versões com continuação. Retornam DH_OK/DH_ABORTED se concluíram na
+ * hora (o waiter NÃO é notificado nesse caso) ou DH_PENDING se a espera
+ * foi registrada (o waiter será concluído por quem liberar a condição).
+ */
+dh_status_t dh_enter_async(dh_hall_t* hall, dh_waiter_t* waiter);
+dh_status_t dh_leave_async(dh_hall_t* hall, dh_waiter_t* waiter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DININGHALL_H */
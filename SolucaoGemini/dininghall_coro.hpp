@@ -0,0 +1,167 @@
+/*
+ * dininghall_coro.hpp
+ * Front-end C++20 (corrotinas) para a libdininghall.
+ *
+ *     bool sat = co_await hall.enter(id);   // suspende em vez de bloquear
+ *     co_await hall.leave(id);
+ *
+ * Por baixo usa dh_enter_async / dh_leave_async: o dh_waiter_t fica dentro
+ * do awaiter, que vive no frame da corrotina. Ou seja, a fila de espera é
+ * intrusiva e nenhuma espera aloca memória. A retomada da corrotina não é
+ * feita dentro do callback da biblioteca: ela é entregue a um Executor
+ * plugável (o mesmo nó intrusivo é usado na fila do executor).
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#ifndef DININGHALL_CORO_HPP
+#define DININGHALL_CORO_HPP
+
+#include <coroutine>
+#include <exception>
+#include <stdexcept>
+
+#include "dininghall.h"
+
+namespace dh {
+
+/* Nó intrusivo: uma corrotina pronta para ser retomada */
+struct Resumable {
+    std::coroutine_handle<> handle;
+    Resumable* next = nullptr;
+};
+
+/* Executor plugável: decide onde/quando as corrotinas são retomadas */
+class Executor {
+public:
+    virtual ~Executor() = default;
+    virtual void schedule(Resumable* task) = 0;
+};
+
+/* Retoma na hora, na thread que liberou a espera */
+class InlineExecutor final : public Executor {
+public:
+    void schedule(Resumable* task) override { task->handle.resume(); }
+};
+
+/* Fila FIFO intrusiva, drenada por quem chamar run_ready() (uma thread) */
+class QueueExecutor final : public Executor {
+public:
+    void schedule(Resumable* task) override {
+        task->next = nullptr;
+        if (tail_) tail_->next = task;
+        else head_ = task;
+        tail_ = task;
+    }
+
+    bool empty() const { return head_ == nullptr; }
+
+    /* Retoma todas as corrotinas prontas (inclusive as que ficarem prontas no caminho) */
+    void run_ready() {
+        while (head_) {
+            Resumable* task = head_;
+            head_ = task->next;
+            if (head_ == nullptr) tail_ = nullptr;
+            task->handle.resume();
+        }
+    }
+
+private:
+    Resumable* head_ = nullptr;
+    Resumable* tail_ = nullptr;
+};
+
+/* Base dos awaiters do refeitório: dh_waiter_t + nó do executor */
+class HallAwaiter {
+protected:
+    HallAwaiter(dh_hall_t* hall, Executor& executor, int id)
+        : hall_(hall), executor_(executor) {
+        waiter_.id = id;
+        waiter_.callback = &HallAwaiter::on_done;
+        waiter_.user_data = this;
+        waiter_.event_fd = -1;
+    }
+
+    static void on_done(dh_waiter_t* waiter, dh_status_t) {
+        auto* self = static_cast<HallAwaiter*>(waiter->user_data);
+        self->executor_.schedule(&self->node_);
+    }
+
+    dh_hall_t* hall_;
+    Executor& executor_;
+    dh_waiter_t waiter_{};
+    Resumable node_;
+};
+
+/* co_await hall.enter(id) -> true se sentou, false se abortou */
+class EnterAwaiter : HallAwaiter {
+public:
+    EnterAwaiter(dh_hall_t* hall, Executor& executor, int id)
+        : HallAwaiter(hall, executor, id) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+        node_.handle = handle;
+        // Se concluiu na hora, não suspende
+        return dh_enter_async(hall_, &waiter_) == DH_PENDING;
+    }
+
+    bool await_resume() const noexcept { return waiter_.status == DH_OK; }
+};
+
+/* co_await hall.leave(id) */
+class LeaveAwaiter : HallAwaiter {
+public:
+    LeaveAwaiter(dh_hall_t* hall, Executor& executor, int id)
+        : HallAwaiter(hall, executor, id) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+        node_.handle = handle;
+        return dh_leave_async(hall_, &waiter_) == DH_PENDING;
+    }
+
+    void await_resume() const noexcept {}
+};
+
+/* Dono RAII de um dh_hall_t com interface de corrotinas (motor "mutex", o único assíncrono) */
+class Hall {
+public:
+    Hall(int total_students, Executor& executor)
+        : hall_(dh_create_engine("mutex", total_students)), executor_(executor) {
+        if (hall_ == nullptr) throw std::invalid_argument("dh_create falhou");
+    }
+    ~Hall() { dh_destroy(hall_); }
+
+    Hall(const Hall&) = delete;
+    Hall& operator=(const Hall&) = delete;
+
+    EnterAwaiter enter(int id) { return EnterAwaiter(hall_, executor_, id); }
+    LeaveAwaiter leave(int id) { return LeaveAwaiter(hall_, executor_, id); }
+    void done(int id) { dh_done(hall_, id); }
+
+    dh_hall_t* handle() const { return hall_; }
+
+private:
+    dh_hall_t* hall_;
+    Executor& executor_;
+};
+
+/*
+ * Corrotina "dispara e esquece": começa na hora e libera o próprio frame
+ * ao terminar. Serve para as rotinas de estudante.
+ */
+struct Task {
+    struct promise_type {
+        Task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+} // namespace dh
+
+#endif /* DININGHALL_CORO_HPP */
@@ -3,11 +3,20 @@ import subprocess
 import sys
 import time
 import shutil
+import os
 
 # --- Configurações do Teste ---
 BINARY_NAME = "./dining_hall"
 TIMEOUT_SECONDS = 5
 NUM_RUNS = 30
+# As execuções pares gravam o escalonamento (dining_hall -r); o das que
+# falham fica aqui para reproduzir com: ./stress_tester.py --replay <arquivo>
+# As ímpares rodam sem gravação, exatamente como o binário roda sozinho.
+SCHEDULE_DIR = "schedules"
+# --fuzz: rodadas curtas com perturbação do escalonamento (dining_hall -F)
+FUZZ_ROUNDS = 2000
+# Violação de invariante do monitor derruba o processo na hora (vira "E")
+RUN_ENV = dict(os.environ, DH_CHECK="abort")
 SCENARIOS = [
     {"users": 2,  "label": "Par (Minimal Check)"},
     {"users": 3,  "label": "Ímpar (Edge Case - Sobra 1?)"},
@@ -60,6 +69,8 @@ def run_stress_test():
     print(f"⏱️  Timeout definido: {TIMEOUT_SECONDS}s por execução\n")
 
     summary = []
+    failures = []
+    os.makedirs(SCHEDULE_DIR, exist_ok=True)
 
     for scenario in SCENARIOS:
         users = scenario["users"]
@@ -75,12 +86,17 @@ def run_stress_test():
         avg_time = 0
         
         for i in range(NUM_RUNS):
+            record = i % 2 == 0
+            schedule = os.path.join(SCHEDULE_DIR, f"n{users}_run{i:02d}.sched")
+            cmd = [BINARY_NAME, "-r", schedule, str(users)] if record else [BINARY_NAME, str(users)]
+            failed = True
             start_time = time.time()
             try:
                 # Executa o binário e espera finalizar
                 proc = subprocess.run(
-                    [BINARY_NAME, str(users)], 
+                    cmd,
                     timeout=TIMEOUT_SECONDS,
+                    env=RUN_ENV,
                     stdout=subprocess.DEVNULL, # Silencia output do C para não poluir
                     stderr=subprocess.PIPE
                 )
@@ -89,6 +105,7 @@ def run_stress_test():
                     sys.stdout.write(f"{Colors.OKGREEN}.{Colors.ENDC}") # Ponto verde = Sucesso
                     success_count += 1
                     avg_time += (time.time() - start_time)
+                    failed = False
                 else:
                     sys.stdout.write(f"{Colors.FAIL}E{Colors.ENDC}") # E = Erro de Runtime (segfault, etc)
                     fail_count += 1
@@ -99,6 +116,10 @@ def run_stress_test():
                 # O processo é morto automaticamente pelo python após o timeout exception, 
                 # mas para garantir limpeza em casos extremos, o subprocess.run cuida disso no Python 3.7+
             
+            if failed:
+                failures.append(schedule if record else f"{users} estudantes, run {i:02d} (sem gravação)")
+            elif os.path.exists(schedule):
+                os.remove(schedule)
             sys.stdout.flush()
 
         # Calcula média
@@ -114,6 +135,15 @@ def run_stress_test():
         })
         print("\n") # Quebra linha após os pontos
 
+    if failures:
+        print_status("🎞️  Escalonamentos das falhas (reproduzir com --replay):", Colors.WARNING)
+        for schedule in failures:
+            if schedule.endswith(".sched"):
+                print(f"   {sys.argv[0]} --replay {schedule}")
+            else:
+                print(f"   {schedule}")
+        print()
+
     return summary
 
 def print_report(summary):
@@ -147,7 +177,46 @@ def print_report(summary):
         print_status("\n💀 RESULTADO: REPROVADO. Foram detectados problemas de estabilidade.", Colors.FAIL)
         sys.exit(1)
 
+def replay(schedule):
+    """Reproduz uma falha gravada: mesma ordem de lock/acordares e sorteios."""
+    # O nome diz quantos estudantes (n<users>_run<i>.sched)
+    users = os.path.basename(schedule).split("_")[0].lstrip("n")
+    print_status(f"🎞️  [REPLAY] {schedule} ({users} estudantes)", Colors.HEADER)
+    try:
+        proc = subprocess.run([BINARY_NAME, "-R", schedule, users], timeout=TIMEOUT_SECONDS,
+                              env=RUN_ENV)
+        if proc.returncode == 0:
+            print_status("✅ Terminou (a falha não se repetiu).", Colors.OKGREEN)
+        else:
+            print_status(f"❌ Erro reproduzido (código {proc.returncode}).", Colors.FAIL)
+        sys.exit(proc.returncode)
+    except subprocess.TimeoutExpired:
+        print_status("💀 Deadlock reproduzido (timeout).", Colors.FAIL)
+        sys.exit(1)
+
+def fuzz(seed):
+    """Fuzzer no binário: milhares de rodadas por cenário, no lugar dos 30 runs."""
+    print_status(f"🎲 [FUZZ] {FUZZ_ROUNDS} rodadas/cenário, semente {seed}", Colors.BOLD)
+    all_passed = True
+    for scenario in SCENARIOS:
+        users = scenario["users"]
+        print(f"{Colors.HEADER}Fuzz: {users} Estudantes - [{scenario['label']}]{Colors.ENDC}")
+        proc = subprocess.run(
+            [BINARY_NAME, "-F", str(seed), "-k", str(FUZZ_ROUNDS), str(users)],
+            stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True
+        )
+        lines = proc.stdout.strip().splitlines()
+        print(lines[-1] if lines else "")
+        if proc.returncode != 0:
+            all_passed = False
+            print_status(proc.stderr.strip(), Colors.FAIL)
+    sys.exit(0 if all_passed else 1)
+
 if __name__ == "__main__":
+    if len(sys.argv) == 3 and sys.argv[1] == "--replay":
+        replay(sys.argv[2])
     check_compilation()
+    if len(sys.argv) >= 2 and sys.argv[1] == "--fuzz":
+        fuzz(sys.argv[2] if len(sys.argv) > 2 else int(time.time()))
     results = run_stress_test()
     print_report(results)
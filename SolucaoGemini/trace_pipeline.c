@@ -0,0 +1,454 @@
+/*
+ * trace_pipeline.c
+ * Geração paralela e retomável de um corpus de rastros (.dht, ver
+ * dh_trace.h). Substitui o laço sequencial do trace_generator.py:
+ *
+ *   - cada rodada (cenário n x semente) roda num processo filho próprio,
+ *     fixado numa das CPUs permitidas ao processo, com até -j rodadas ao
+ *     mesmo tempo;
+ *   - cada estudante usa rand_r com semente derivada de (seed, id), então
+ *     a carga (sleeps) de uma rodada é reprodutível;
+ *   - o filho escreve em <arquivo>.tmp e só renomeia depois do rodapé e do
+ *     fsync: se o pipeline for interrompido, rodar de novo com os mesmos
+ *     parâmetros pula as rodadas prontas e refaz só as que faltam;
+ *   - ao final, MANIFEST.tsv lista todas as rodadas completas do diretório;
+ *   - um lock (flock em <dir>/.lock) impede dois pipelines no mesmo diretório.
+ *
+ * Pilhas de 64 KiB por thread permitem cenários de 10k estudantes.
+ *
+ * Uso: ./trace_pipeline [-o dir] [-n n1,n2] [-k rodadas] [-i iteracoes]
+ *                       [-s min:max (us)] [-j jobs] [-e motor] [-r seed]
+ *                       [-t timeout (s)]
+ *      ./trace_pipeline -d arquivo.dht    (imprime o rastro em texto)
+ * Authors: Miguel Badany Cerne & Pedro Videira Rubinstein
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "dininghall.h"
+#include "dh_trace.h"
+
+/* Pilha das threads de estudante (o padrão de 8 MiB não escala a 10k) */
+#define STUDENT_STACK_SIZE (64 * 1024)
+
+typedef struct {
+    const char* out_dir;
+    const char* engine;
+    int num_iterations;
+    int min_sleep_us;
+    int max_sleep_us;
+    int jobs;
+    int timeout_s;
+} PipelineConfig;
+
+/* Uma rodada do corpus */
+typedef struct {
+    int num_students;
+    uint64_t seed;
+    char path[512];
+    pid_t pid;
+    double started;
+} TraceJob;
+
+typedef struct {
+    int id;
+    dh_hall_t* hall;
+    const PipelineConfig* cfg;
+    unsigned rng;
+    dh_trace_buffer trace;
+} TraceStudent;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * CPUs em que o processo pode rodar (taskset, cgroups), em ordem. Sem a
+ * máscara, cai para 0..N-1 das online. Retorna quantas; NULL em `out` só
+ * se faltou memória.
+ */
+static int allowed_cpus(int** out) {
+    cpu_set_t set;
+    int count = 0;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) count = CPU_COUNT(&set);
+    if (count < 1) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        count = online < 1 ? 1 : (int)online;
+        CPU_ZERO(&set);
+        for (int cpu = 0; cpu < count && cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu, &set);
+    }
+
+    *out = malloc(sizeof(int) * count);
+    if (*out == NULL) return 0;
+    int n = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE && n < count; cpu++) {
+        if (CPU_ISSET(cpu, &set)) (*out)[n++] = cpu;
+    }
+    return n;
+}
+
+static void trace_sleep(TraceStudent* s) {
+    const PipelineConfig* cfg = s->cfg;
+    int span = cfg->max_sleep_us - cfg->min_sleep_us + 1;
+    int us = cfg->min_sleep_us + (int)(rand_r(&s->rng) % (unsigned)span);
+    if (us > 0) usleep(us);
+}
+
+static void* trace_student(void* arg) {
+    TraceStudent* s = arg;
+
+    for (int i = 0; i < s->cfg->num_iterations; i++) {
+        dh_trace_emit(&s->trace, s->id, DH_TEV_GET_FOOD, s->hall);
+        trace_sleep(s);
+
+        dh_trace_emit(&s->trace, s->id, DH_TEV_REQ_ENTRY, s->hall);
+        if (!dh_enter(s->hall, s->id)) {
+            dh_trace_emit(&s->trace, s->id, DH_TEV_ABORT_ENTRY, s->hall);
+            break;
+        }
+        dh_trace_emit(&s->trace, s->id, DH_TEV_ENTERED, s->hall);
+
+        dh_trace_emit(&s->trace, s->id, DH_TEV_EATING, s->hall);
+        trace_sleep(s);
+
+        dh_trace_emit(&s->trace, s->id, DH_TEV_REQ_LEAVE, s->hall);
+        dh_leave(s->hall, s->id);
+        dh_trace_emit(&s->trace, s->id, DH_TEV_LEFT, s->hall);
+    }
+
+    dh_done(s->hall, s->id);
+    dh_trace_emit(&s->trace, s->id, DH_TEV_FINISHED, s->hall);
+    dh_trace_flush(&s->trace);
+    return NULL;
+}
+
+/* Filho: roda uma simulação inteira gravando em `tmp_path`. Retorna 0 se ok. */
+static int run_trace(const PipelineConfig* cfg, const TraceJob* job, const char* tmp_path, int cpu) {
+    dh_hall_t* hall = dh_create_engine(cfg->engine, job->num_students);
+    if (hall == NULL) {
+        fprintf(stderr, "Erro: motor desconhecido '%s'.\n", cfg->engine);
+        return 1;
+    }
+
+    dh_trace_header header = {
+        .num_students = (uint32_t)job->num_students,
+        .num_iterations = (uint32_t)cfg->num_iterations,
+        .min_sleep_us = (uint32_t)cfg->min_sleep_us,
+        .max_sleep_us = (uint32_t)cfg->max_sleep_us,
+        .cpu = (uint32_t)cpu,
+        .seed = job->seed,
+    };
+    snprintf(header.engine, sizeof(header.engine), "%s", cfg->engine);
+
+    dh_trace_writer writer;
+    if (dh_trace_open(&writer, tmp_path, &header) != 0) {
+        perror(tmp_path);
+        dh_destroy(hall);
+        return 1;
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, STUDENT_STACK_SIZE);
+
+    int n = job->num_students;
+    pthread_t* threads = malloc(sizeof(pthread_t) * n);
+    TraceStudent* students = calloc(n, sizeof(TraceStudent));
+    int created = 0;
+
+    for (int i = 0; i < n; i++) {
+        students[i].id = i + 1;
+        students[i].hall = hall;
+        students[i].cfg = cfg;
+        // Semente por estudante: mistura a semente da rodada com o id
+        students[i].rng = (unsigned)(job->seed * 2654435761u) ^ (unsigned)(i + 1);
+        students[i].trace.writer = &writer;
+        if (pthread_create(&threads[i], &attr, trace_student, &students[i]) != 0) {
+            fprintf(stderr, "Erro: não consegui criar a thread %d de %d.\n", i + 1, n);
+            _exit(1); // Estudantes já criados esperariam um par que não vem
+        }
+        created++;
+    }
+    for (int i = 0; i < created; i++) pthread_join(threads[i], NULL);
+
+    pthread_attr_destroy(&attr);
+    free(students);
+    free(threads);
+    dh_destroy(hall);
+    return dh_trace_close(&writer) == 0 ? 0 : 1;
+}
+
+/* Filho: fixa na CPU, roda, e publica o arquivo final com rename */
+static void child_main(const PipelineConfig* cfg, const TraceJob* job, int cpu) {
+    if (cfg->timeout_s > 0) alarm(cfg->timeout_s); // SIGALRM mata o filho (deadlock?)
+
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            // Roda assim mesmo, mas o cabeçalho não finge a fixação
+            fprintf(stderr, "Aviso: não fixei %s na CPU %d: %s\n",
+                    strrchr(job->path, '/') + 1, cpu, strerror(errno));
+            cpu = -1;
+        }
+    }
+
+    char tmp_path[sizeof(job->path) + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", job->path);
+
+    if (run_trace(cfg, job, tmp_path, cpu) != 0) {
+        unlink(tmp_path);
+        _exit(1);
+    }
+    if (rename(tmp_path, job->path) != 0) {
+        perror(job->path);
+        _exit(1);
+    }
+    _exit(0);
+}
+
+/* Reescreve MANIFEST.tsv com todas as rodadas completas do diretório */
+static void write_manifest(const char* dir) {
+    char path[512], tmp[520];
+    snprintf(path, sizeof(path), "%s/MANIFEST.tsv", dir);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    DIR* d = opendir(dir);
+    FILE* out = fopen(tmp, "w");
+    if (d == NULL || out == NULL) {
+        if (d) closedir(d);
+        if (out) fclose(out);
+        return;
+    }
+
+    fprintf(out, "arquivo\tmotor\tn\titeracoes\tseed\tcpu\tregistros\n");
+    struct dirent* e;
+    while ((e = readdir(d)) != NULL) {
+        size_t len = strlen(e->d_name);
+        if (len < 4 || strcmp(e->d_name + len - 4, ".dht") != 0) continue;
+
+        char file[1024];
+        snprintf(file, sizeof(file), "%s/%s", dir, e->d_name);
+        dh_trace_header h;
+        uint64_t records;
+        if (dh_trace_check(file, &h, &records) != 0) continue;
+        fprintf(out, "%s\t%.16s\t%u\t%u\t%llu\t%d\t%llu\n", e->d_name, h.engine,
+                h.num_students, h.num_iterations, (unsigned long long)h.seed,
+                (int)h.cpu, (unsigned long long)records);
+    }
+    closedir(d);
+    fclose(out);
+    rename(tmp, path);
+}
+
+static bool parse_range(const char* str, int* lo, int* hi) {
+    if (sscanf(str, "%d:%d", lo, hi) != 2) return false;
+    return *lo >= 0 && *hi >= *lo;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "Uso: %s [-o dir] [-n n1,n2] [-k rodadas] [-i iteracoes] "
+                    "[-s min:max (us)] [-j jobs] [-e motor] [-r seed] [-t timeout (s)]\n"
+                    "     %s -d arquivo.dht\n", prog, prog);
+}
+
+int main(int argc, char* argv[]) {
+    int* cpus;
+    int ncpu = allowed_cpus(&cpus);
+    if (cpus == NULL) {
+        perror("malloc");
+        return 1;
+    }
+
+    PipelineConfig cfg = {
+        .out_dir = "trace_corpus",
+        .engine = "mutex",
+        .num_iterations = 5,           // Mesmos padrões de dining_hall_logged.c
+        .min_sleep_us = 10000,
+        .max_sleep_us = 50000,
+        .jobs = ncpu,
+        .timeout_s = 60,
+    };
+    const char* counts = "2,3,10";
+    int runs = 1;
+    uint64_t base_seed = 42;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:n:k:i:s:j:e:r:t:d:")) != -1) {
+        switch (opt) {
+        case 'o': cfg.out_dir = optarg; break;
+        case 'n': counts = optarg; break;
+        case 'k': runs = atoi(optarg); break;
+        case 'i': cfg.num_iterations = atoi(optarg); break;
+        case 's':
+            if (!parse_range(optarg, &cfg.min_sleep_us, &cfg.max_sleep_us)) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'j': cfg.jobs = atoi(optarg); break;
+        case 'e': cfg.engine = optarg; break;
+        case 'r': base_seed = strtoull(optarg, NULL, 10); break;
+        case 't': cfg.timeout_s = atoi(optarg); break;
+        case 'd':
+            if (dh_trace_dump(optarg, stdout) != 0) {
+                fprintf(stderr, "Erro: '%s' não é um rastro completo.\n", optarg);
+                return 1;
+            }
+            return 0;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (cfg.jobs < 1 || runs < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (mkdir(cfg.out_dir, 0755) != 0 && errno != EEXIST) {
+        perror(cfg.out_dir);
+        return 1;
+    }
+
+    // Um pipeline por diretório: os filhos herdam o lock, então nem os
+    // órfãos de uma execução interrompida disputam os mesmos .tmp
+    char lock_path[512];
+    snprintf(lock_path, sizeof(lock_path), "%s/.lock", cfg.out_dir);
+    int lock_fd = open(lock_path, O_RDWR | O_CREAT, 0644);
+    if (lock_fd < 0 || flock(lock_fd, LOCK_EX | LOCK_NB) != 0) {
+        fprintf(stderr, "Erro: %s está em uso por outro pipeline.\n", cfg.out_dir);
+        return 1;
+    }
+
+    // Monta a lista de rodadas: cada cenário com `runs` sementes
+    int max_jobs = 0;
+    for (const char* c = counts; *c; c++) if (*c == ',') max_jobs++;
+    max_jobs = (max_jobs + 1) * runs;
+    TraceJob* jobs = calloc(max_jobs, sizeof(TraceJob));
+    int num_jobs = 0, ready = 0;
+
+    char* count_list = strdup(counts);
+    char* save = NULL;
+    for (char* count = strtok_r(count_list, ",", &save); count; count = strtok_r(NULL, ",", &save)) {
+        int n = atoi(count);
+        if (n < 2) {
+            fprintf(stderr, "Erro: Minimo 2 estudantes (cenário '%s').\n", count);
+            return 1;
+        }
+        for (int k = 0; k < runs; k++) {
+            TraceJob* job = &jobs[num_jobs++];
+            job->num_students = n;
+            job->seed = base_seed + (uint64_t)k;
+            snprintf(job->path, sizeof(job->path), "%s/trace_n%d_i%d_%s_s%llu.dht",
+                     cfg.out_dir, n, cfg.num_iterations, cfg.engine,
+                     (unsigned long long)job->seed);
+
+            // Retomada: rodada completa (rodapé válido) não roda de novo
+            if (dh_trace_check(job->path, NULL, NULL) == 0) {
+                job->pid = -1;
+                ready++;
+            }
+        }
+    }
+    free(count_list);
+
+    printf("%d rodadas (%d já prontas), %d em paralelo, motor=%s -> %s/\n",
+           num_jobs, ready, cfg.jobs, cfg.engine, cfg.out_dir);
+    fflush(stdout);
+
+    // Escalonador: até cfg.jobs filhos; o slot decide a CPU do filho
+    int* slot_cpu_busy = calloc(cfg.jobs, sizeof(int));
+    TraceJob** running = calloc(cfg.jobs, sizeof(TraceJob*));
+    int next = 0, active = 0, done = ready, failed = 0;
+
+    while (next < num_jobs || active > 0) {
+        while (active < cfg.jobs && next < num_jobs) {
+            TraceJob* job = &jobs[next++];
+            if (job->pid == -1) continue; // Já pronta
+
+            int slot = 0;
+            while (running[slot]) slot++;
+            int cpu = cpus[slot % ncpu];
+
+            job->started = now_s();
+            pid_t pid = fork();
+            if (pid < 0) {
+                perror("fork");
+                return 1;
+            }
+            if (pid == 0) child_main(&cfg, job, cpu);
+
+            job->pid = pid;
+            running[slot] = job;
+            slot_cpu_busy[slot] = cpu;
+            active++;
+        }
+        if (active == 0) break;
+
+        int status;
+        pid_t pid = wait(&status);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        for (int slot = 0; slot < cfg.jobs; slot++) {
+            TraceJob* job = running[slot];
+            if (job == NULL || job->pid != pid) continue;
+
+            running[slot] = NULL;
+            active--;
+            done++;
+
+            const char* name = strrchr(job->path, '/') + 1;
+            double secs = now_s() - job->started;
+            uint64_t records = 0;
+            if (WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                dh_trace_check(job->path, NULL, &records) == 0) {
+                printf("[%d/%d] %s ok (cpu %d, %llu registros, %.2fs)\n", done, num_jobs,
+                       name, slot_cpu_busy[slot], (unsigned long long)records, secs);
+            } else {
+                char tmp_path[sizeof(job->path) + 8];
+                snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", job->path);
+                unlink(tmp_path);
+                failed++;
+                if (WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM) {
+                    printf("[%d/%d] %s TIMEOUT após %ds (Deadlock?)\n", done, num_jobs,
+                           name, cfg.timeout_s);
+                } else {
+                    printf("[%d/%d] %s ERRO\n", done, num_jobs, name);
+                }
+            }
+            fflush(stdout);
+            break;
+        }
+    }
+
+    write_manifest(cfg.out_dir);
+    printf("%d/%d rodadas completas, %d falharam. Manifesto: %s/MANIFEST.tsv\n",
+           num_jobs - failed, num_jobs, failed, cfg.out_dir);
+
+    free(running);
+    free(slot_cpu_busy);
+    free(cpus);
+    free(jobs);
+    return failed ? 1 : 0;
+}